@@ -0,0 +1,404 @@
+/*Benchmarks for insert, lookup and scan workloads.
+Links against the engine (no REPL, no text parsing) and
+prints one JSON object per workload on stdout.
+
+Build and run from the repo root:
+    gcc -O2 bench/bench.c db.c -o bench/bench
+    ./bench/bench [--workload <name>] [--rows N] [--ops N]
+                  [--threads N] [--cache warm|cold|both] [--seed N] [--db path]
+                  [--io buffered|direct] [--index tree|hash]
+
+Workloads: seq_insert, random_insert, point_lookup, range_scan, mixed.
+Warm lookups and scans can run on several threads, inserts are single threaded.
+"cold" closes the database and drops its pages from the OS page cache before
+every measured op, then reopens it, so each op starts with an empty pager cache
+and reads from disk. Only the op is timed, not the reopen; cold runs are single
+threaded and capped at BENCH_MAX_COLD_OPS ops.
+--index hash builds the hash index on id, so lookups skip the tree descent.*/
+
+#include<errno.h>
+#include<fcntl.h>
+#include<string.h>
+#include<unistd.h>
+#include "../db_internal.h"
+
+//the tree can't split a non-root leaf yet, every key order fits in this
+#define BENCH_MAX_ROWS (LEAF_NODE_MAX_CELLS+LEAF_NODE_LEFT_SPLIT_COUNT)
+#define BENCH_RANGE_LENGTH 5
+#define BENCH_MAX_THREADS 64
+#define BENCH_MAX_COLD_OPS 2000 //every cold op pays for a close, fsync and reopen
+
+typedef struct{
+    const char* workload; //NULL = all
+    uint32_t rows;
+    uint64_t ops;
+    uint32_t threads;
+    const char* cache; //warm, cold or both
+    uint64_t seed;
+    const char* db_path;
+    uint32_t open_flags; //DB_OPEN_DIRECT_IO for --io direct
+    bool hash_index;
+}BenchOptions;
+
+typedef struct{
+    LatencyHistogram histogram;
+    uint64_t ops;
+    uint64_t elapsed_ns;
+}BenchResult;
+
+typedef struct{
+    Table* table;
+    uint32_t rows;
+    uint64_t ops;
+    uint64_t seed;
+    bool range;
+    LatencyHistogram histogram;
+}ReadWorker;
+
+//xorshift64*, deterministic for a given seed
+uint64_t bench_random(uint64_t* state){
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+void shuffle_keys(uint32_t* keys, uint32_t count, uint64_t* state){
+    for(uint32_t i = count; i > 1; i--){
+        uint32_t j = bench_random(state) % i;
+        uint32_t temp = keys[i-1];
+        keys[i-1] = keys[j];
+        keys[j] = temp;
+    }
+}
+
+void make_row(uint32_t key, Statement* statement){
+    statement->type = STATEMENT_INSERT;
+    statement->row_to_insert.id = key;
+    snprintf(statement->row_to_insert.username, COLUMN_USERNAME_SIZE+1, "user%d", key);
+    snprintf(statement->row_to_insert.email, COLUMN_EMAIL_SIZE+1, "person%d@example.com", key);
+}
+
+Table* open_fresh(BenchOptions* options){
+    unlink(options->db_path);
+    Table* table = db_open_flags(options->db_path, options->open_flags);
+    if(options->hash_index){
+        db_create_hash_index(table);
+    }else{
+        db_drop_hash_index(table);
+    }
+    return table;
+}
+
+void insert_key(Table* table, uint32_t key){
+    Statement statement;
+    make_row(key, &statement);
+    if(execute_statement(&statement, table) != EXECUTE_SUCCESS){
+        printf("Error: insert of %d failed\n", key);
+        exit(EXIT_FAILURE);
+    }
+}
+
+bool lookup_key(Table* table, uint32_t key, Row* row){
+    Cursor cursor;
+    bool found = table_lookup(table, key, &cursor);
+    if(found){
+        deserialize_row(cursor_value(&cursor), row);
+    }
+    return found;
+}
+
+/*Reads up to BENCH_RANGE_LENGTH rows from key on: seeks to the first one,
+and at the end of a leaf seeks again past the last key read*/
+void range_scan(Table* table, uint32_t key, Row* row){
+    uint32_t remaining = BENCH_RANGE_LENGTH;
+    while(remaining > 0){
+        Cursor cursor;
+        table_find(table, key, &cursor);
+        void* node = get_page(table->pager, cursor.page_num);
+        uint32_t num_cells = *leaf_node_num_cells(node);
+        if(cursor.cell_num >= num_cells){
+            return; //past the last key
+        }
+        for(; cursor.cell_num < num_cells && remaining > 0; cursor.cell_num++){
+            deserialize_row(leaf_node_value(node, cursor.cell_num), row);
+            remaining -= 1;
+        }
+        key = row->id+1;
+    }
+}
+
+void read_op(Table* table, uint32_t key, bool range, Row* row){
+    if(range){
+        range_scan(table, key, row);
+    }else if(!lookup_key(table, key, row)){
+        printf("Error: key %d not found\n", key);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void* read_worker(void* arg){
+    ReadWorker* worker = arg;
+    uint64_t state = worker->seed;
+    Row row;
+    for(uint64_t i = 0; i < worker->ops; i++){
+        uint32_t key = bench_random(&state) % worker->rows + 1;
+        uint64_t start = now_ns();
+        read_op(worker->table, key, worker->range, &row);
+        latency_record(&worker->histogram, now_ns()-start);
+    }
+    return NULL;
+}
+
+//writes back and evicts path's pages from the OS page cache
+void drop_os_cache(const char* path){
+    int fd = open(path, O_RDONLY);
+    if(fd == -1){
+        return; //no hash index
+    }
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/*Closes the database and reopens it with nothing cached, for a cold op*/
+Table* reopen_cold(Table* table, BenchOptions* options){
+    db_close(table);
+    char index_path[4096];
+    snprintf(index_path, sizeof(index_path), "%s-hash", options->db_path);
+    drop_os_cache(options->db_path);
+    drop_os_cache(index_path);
+    return db_open_flags(options->db_path, options->open_flags);
+}
+
+uint64_t cold_ops(BenchOptions* options){
+    return options->ops < BENCH_MAX_COLD_OPS ? options->ops : BENCH_MAX_COLD_OPS;
+}
+
+void merge_histogram(LatencyHistogram* into, LatencyHistogram* from){
+    for(uint32_t i = 0; i < LATENCY_BUCKETS; i++){
+        into->counts[i] += from->counts[i];
+    }
+    into->total_count += from->total_count;
+    if(from->max > into->max){
+        into->max = from->max;
+    }
+}
+
+/*Inserts rows keys per round into a fresh database until ops inserts are done*/
+void bench_insert(BenchOptions* options, bool random_order, BenchResult* result){
+    uint32_t keys[BENCH_MAX_ROWS];
+    uint64_t state = options->seed;
+    while(result->ops < options->ops){
+        Table* table = open_fresh(options);
+        for(uint32_t i = 0; i < options->rows; i++){
+            keys[i] = i+1;
+        }
+        if(random_order){
+            shuffle_keys(keys, options->rows, &state);
+        }
+        for(uint32_t i = 0; i < options->rows && result->ops < options->ops; i++){
+            uint64_t start = now_ns();
+            insert_key(table, keys[i]);
+            uint64_t elapsed = now_ns()-start;
+            latency_record(&result->histogram, elapsed);
+            result->elapsed_ns += elapsed;
+            result->ops += 1;
+        }
+        db_close(table);
+    }
+}
+
+/*Point lookups or short range scans over a table of rows keys*/
+void bench_read(BenchOptions* options, bool range, bool cold, BenchResult* result){
+    Table* table = open_fresh(options);
+    for(uint32_t i = 0; i < options->rows; i++){
+        insert_key(table, i+1);
+    }
+    if(cold){
+        uint64_t state = options->seed;
+        Row row;
+        for(uint64_t i = 0; i < cold_ops(options); i++){
+            uint32_t key = bench_random(&state) % options->rows + 1;
+            table = reopen_cold(table, options);
+            uint64_t start = now_ns();
+            read_op(table, key, range, &row);
+            uint64_t elapsed = now_ns()-start;
+            latency_record(&result->histogram, elapsed);
+            result->elapsed_ns += elapsed;
+            result->ops += 1;
+        }
+        db_close(table);
+        return;
+    }
+
+    ReadWorker workers[BENCH_MAX_THREADS];
+    pthread_t threads[BENCH_MAX_THREADS];
+    uint64_t start = now_ns();
+    for(uint32_t i = 0; i < options->threads; i++){
+        memset(&workers[i], 0, sizeof(ReadWorker));
+        workers[i].table = table;
+        workers[i].rows = options->rows;
+        workers[i].ops = options->ops/options->threads + (i < options->ops%options->threads);
+        workers[i].seed = options->seed + i;
+        workers[i].range = range;
+        if(pthread_create(&threads[i], NULL, read_worker, &workers[i]) != 0){
+            printf("Error creating bench thread: %d\n", errno);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for(uint32_t i = 0; i < options->threads; i++){
+        pthread_join(threads[i], NULL);
+        merge_histogram(&result->histogram, &workers[i].histogram);
+        result->ops += workers[i].ops;
+    }
+    result->elapsed_ns = now_ns()-start;
+    db_close(table);
+}
+
+/*Each round starts half full, then interleaves inserts of the other half
+with lookups of keys that are already there*/
+void bench_mixed(BenchOptions* options, bool cold, BenchResult* result){
+    uint32_t keys[BENCH_MAX_ROWS];
+    uint64_t state = options->seed;
+    Row row;
+    uint64_t ops = cold ? cold_ops(options) : options->ops;
+    while(result->ops < ops){
+        for(uint32_t i = 0; i < options->rows; i++){
+            keys[i] = i+1;
+        }
+        shuffle_keys(keys, options->rows, &state);
+        uint32_t inserted = options->rows/2;
+        Table* table = open_fresh(options);
+        for(uint32_t i = 0; i < inserted; i++){
+            insert_key(table, keys[i]);
+        }
+
+        bool write = true;
+        while(inserted < options->rows && result->ops < ops){
+            if(cold){
+                table = reopen_cold(table, options);
+            }
+            uint64_t start = now_ns();
+            if(write){
+                insert_key(table, keys[inserted]);
+                inserted += 1;
+            }else if(!lookup_key(table, keys[bench_random(&state) % inserted], &row)){
+                printf("Error: lookup failed\n");
+                exit(EXIT_FAILURE);
+            }
+            uint64_t elapsed = now_ns()-start;
+            latency_record(&result->histogram, elapsed);
+            result->elapsed_ns += elapsed;
+            result->ops += 1;
+            write = !write;
+        }
+        db_close(table);
+    }
+}
+
+void print_result(const char* workload, const char* cache, uint32_t threads,
+                    BenchOptions* options, BenchResult* result){
+    double seconds = result->elapsed_ns/1e9;
+    printf("{\"workload\": \"%s\", \"cache\": \"%s\", \"threads\": %d, \"rows\": %d, "
+            "\"ops\": %llu, \"ops_per_sec\": %.0f, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+            "\"p999_ns\": %llu, \"max_ns\": %llu}\n",
+        workload, cache, threads, options->rows,
+        (unsigned long long)result->ops,
+        seconds > 0 ? result->ops/seconds : 0,
+        (unsigned long long)latency_percentile(&result->histogram, 50),
+        (unsigned long long)latency_percentile(&result->histogram, 99),
+        (unsigned long long)latency_percentile(&result->histogram, 99.9),
+        (unsigned long long)result->histogram.max);
+    fflush(stdout);
+}
+
+bool wants(BenchOptions* options, const char* workload){
+    return options->workload == NULL || !strcmp(options->workload, workload);
+}
+
+void run_workloads(BenchOptions* options, bool cold){
+    const char* cache = cold ? "cold" : "warm";
+    BenchResult* result = malloc(sizeof(BenchResult));
+    //inserts always start from an empty database, cache state doesn't apply
+    if(!cold && wants(options, "seq_insert")){
+        memset(result, 0, sizeof(BenchResult));
+        bench_insert(options, false, result);
+        print_result("seq_insert", "none", 1, options, result);
+    }
+    if(!cold && wants(options, "random_insert")){
+        memset(result, 0, sizeof(BenchResult));
+        bench_insert(options, true, result);
+        print_result("random_insert", "none", 1, options, result);
+    }
+    if(wants(options, "point_lookup")){
+        memset(result, 0, sizeof(BenchResult));
+        bench_read(options, false, cold, result);
+        print_result("point_lookup", cache, cold ? 1 : options->threads, options, result);
+    }
+    if(wants(options, "range_scan")){
+        memset(result, 0, sizeof(BenchResult));
+        bench_read(options, true, cold, result);
+        print_result("range_scan", cache, cold ? 1 : options->threads, options, result);
+    }
+    if(wants(options, "mixed")){
+        memset(result, 0, sizeof(BenchResult));
+        bench_mixed(options, cold, result);
+        print_result("mixed", cache, 1, options, result);
+    }
+    free(result);
+}
+
+void usage(){
+    printf("Usage: bench [--workload <name>] [--rows N] [--ops N] [--threads N]\n"
+            "             [--cache warm|cold|both] [--seed N] [--db path]\n"
+            "             [--io buffered|direct] [--index tree|hash]\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]){
+    BenchOptions options = {NULL, BENCH_MAX_ROWS, 100000, 1, "both", 42, "bench.db", 0, false};
+    for(int i = 1; i < argc; i++){
+        if(i+1 >= argc){
+            usage();
+        }
+        char* value = argv[++i];
+        if(!strcmp(argv[i-1], "--workload")) options.workload = value;
+        else if(!strcmp(argv[i-1], "--rows")) options.rows = atoi(value);
+        else if(!strcmp(argv[i-1], "--ops")) options.ops = strtoull(value, NULL, 10);
+        else if(!strcmp(argv[i-1], "--threads")) options.threads = atoi(value);
+        else if(!strcmp(argv[i-1], "--cache")) options.cache = value;
+        else if(!strcmp(argv[i-1], "--seed")) options.seed = strtoull(value, NULL, 10);
+        else if(!strcmp(argv[i-1], "--db")) options.db_path = value;
+        else if(!strcmp(argv[i-1], "--io") && !strcmp(value, "direct")) options.open_flags = DB_OPEN_DIRECT_IO;
+        else if(!strcmp(argv[i-1], "--io") && !strcmp(value, "buffered")) options.open_flags = 0;
+        else if(!strcmp(argv[i-1], "--index") && !strcmp(value, "hash")) options.hash_index = true;
+        else if(!strcmp(argv[i-1], "--index") && !strcmp(value, "tree")) options.hash_index = false;
+        else usage();
+    }
+    if(options.rows < 2 || options.rows > BENCH_MAX_ROWS){
+        printf("--rows must be between 2 and %d\n", BENCH_MAX_ROWS);
+        exit(EXIT_FAILURE);
+    }
+    if(options.threads < 1 || options.threads > BENCH_MAX_THREADS){
+        printf("--threads must be between 1 and %d\n", BENCH_MAX_THREADS);
+        exit(EXIT_FAILURE);
+    }
+    if(options.seed == 0){
+        options.seed = 1; //xorshift gets stuck on 0
+    }
+
+    bool warm = strcmp(options.cache, "cold") != 0;
+    bool cold = strcmp(options.cache, "warm") != 0;
+    if(warm){
+        run_workloads(&options, false);
+    }
+    if(cold){
+        run_workloads(&options, true);
+    }
+    char index_path[4096];
+    snprintf(index_path, sizeof(index_path), "%s-hash", options.db_path);
+    unlink(index_path);
+    unlink(options.db_path);
+    return 0;
+}
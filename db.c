@@ -0,0 +1,2423 @@
+#define _GNU_SOURCE //for O_DIRECT
+#include<errno.h> //preprocessor macro used for error indication
+#include<fcntl.h> //for open()
+#include<sys/stat.h> //for stat()
+#include<string.h>
+#include<unistd.h> //for open()
+#include<time.h> //for statement latency
+#include<stddef.h> //for max_align_t
+#include "db_internal.h"
+
+//int32_t = fixed size of 32 bits unlike int (which can have any size>=16 bits)
+const uint32_t ID_SIZE = size_of_attribute(Row,id); // 4 bytes
+const uint32_t USERNAME_SIZE = size_of_attribute(Row,username); // 33 bytes
+const uint32_t EMAIL_SIZE = size_of_attribute(Row,email); //256 bytes
+
+const uint32_t ID_OFFSET = 0;
+const uint32_t USERNAME_OFFSET = ID_OFFSET+ID_SIZE;
+const uint32_t EMAIL_OFFSET = USERNAME_OFFSET + USERNAME_SIZE;
+
+const uint32_t ROW_SIZE = ID_SIZE + USERNAME_SIZE + EMAIL_SIZE; //293 bytes
+
+//Row to memory
+void serialize_row(Row* source, void* destination){
+    memcpy(destination+ID_OFFSET, &(source->id),ID_SIZE);
+    memcpy(destination+USERNAME_OFFSET,&(source->username),USERNAME_SIZE);
+    memcpy(destination+EMAIL_OFFSET,&(source->email),EMAIL_SIZE);
+}
+//Memory to row
+void deserialize_row(void* source, Row* destination){
+    memcpy(&(destination->id),source+ID_OFFSET,ID_SIZE);
+    memcpy(&(destination->username),source+USERNAME_OFFSET,USERNAME_SIZE);
+    memcpy(&(destination->email),source+EMAIL_OFFSET,EMAIL_SIZE);
+}
+
+const uint32_t PAGE_SIZE = 4096; //4Kbs same as a page used in most virtual memory systems in most comp. architectures.
+// const uint32_t ROWS_PER_PAGE = PAGE_SIZE/ROW_SIZE; //4096/291 = 14
+// const uint32_t TABLE_MAX_ROWS = ROWS_PER_PAGE * TABLE_MAX_PAGES;
+
+
+//Every node is going to take up exactly one page
+
+//Common Node header format
+/* Metadata needed to be stored in a header at the beginning of
+    the page: what type of node it is, whether root node or not,
+    pointer to its parent (3 total)*/
+//sizeof(uint8_t) indicates 1 byte of memory
+const uint32_t NODE_TYPE_SIZE = sizeof(uint8_t);
+//offset 0 indicates node type field starts at the beginning
+const uint32_t NODE_TYPE_OFFSET = 0; 
+const uint32_t IS_ROOT_SIZE = sizeof(uint8_t);
+const uint32_t IS_ROOT_OFFSET = NODE_TYPE_SIZE;
+const uint32_t PARENT_POINTER_SIZE = sizeof(uint32_t);
+const uint32_t PARENT_POINTER_OFFSET = IS_ROOT_OFFSET+IS_ROOT_SIZE;
+const uint8_t COMMON_NODE_HEADER_SIZE = 
+        NODE_TYPE_SIZE + IS_ROOT_SIZE + PARENT_POINTER_SIZE; //or = PARENT_POINTER_OFFSET + PARENT_POINTER_SIZE
+
+/*Leaf Node Format*/
+/* In addition to the common header fields,
+LEAF nodes need to store how many "cells" they contain.
+A cell = key:value pair*/
+const uint32_t LEAF_NODE_NUM_CELLS_SIZE = sizeof(uint32_t);
+const uint32_t LEAF_NODE_NUM_CELLS_OFFSET = COMMON_NODE_HEADER_SIZE;
+const uint32_t LEAF_NODE_HEADER_SIZE = 
+        COMMON_NODE_HEADER_SIZE + LEAF_NODE_NUM_CELLS_SIZE;
+
+/*Leaf Node Body Layout*/
+/*The body of a leaf node = array of cells*/
+/* Each key is followed by a value*/
+/*value = serialized row*/
+const uint32_t LEAF_NODE_KEY_SIZE = sizeof(uint32_t);
+const uint32_t LEAF_NODE_KEY_OFFSET = 0;
+const uint32_t LEAF_NODE_VALUE_SIZE = ROW_SIZE;
+const uint32_t LEAF_NODE_VALUE_OFFSET = 
+        LEAF_NODE_KEY_OFFSET + LEAF_NODE_KEY_SIZE;
+const uint32_t LEAF_NODE_CELL_SIZE = LEAF_NODE_KEY_SIZE+LEAF_NODE_VALUE_SIZE;
+const uint32_t LEAF_NODE_SPACE_FOR_CELLS = PAGE_SIZE - LEAF_NODE_HEADER_SIZE;
+const uint32_t LEAF_NODE_MAX_CELLS = 
+        LEAF_NODE_SPACE_FOR_CELLS / LEAF_NODE_CELL_SIZE;
+
+bool is_node_root(void* node){
+    uint8_t value = *((uint8_t*)node+IS_ROOT_OFFSET);
+    return (bool)value;
+}
+void set_node_root(void* node, bool is_root){
+    uint8_t value = is_root;
+    *((uint8_t*)(node + IS_ROOT_OFFSET)) = value;
+}
+/*Accessing Leaf Node Fields*/
+/* These methods return a pointer in question,
+so they can be used as both a getter and a setter*/
+/*The code to access keys, values and metadata all involve
+pointer arithmetic using the constants we just defined*/
+uint32_t* leaf_node_num_cells(void* node){
+    return node+LEAF_NODE_NUM_CELLS_OFFSET;
+}
+
+void* leaf_node_cell(void* node, uint32_t cell_num){
+    return node+LEAF_NODE_HEADER_SIZE + cell_num*LEAF_NODE_CELL_SIZE;
+}
+
+uint32_t* leaf_node_key(void* node, uint32_t cell_num){
+    return leaf_node_cell(node, cell_num);
+}
+
+void* leaf_node_value(void* node, uint32_t cell_num){
+    return leaf_node_cell(node,cell_num)+LEAF_NODE_KEY_SIZE;
+}
+/*cast to uint8_t to ensure it's serialized as a single byte*/
+NodeType get_node_type(void* node){
+    uint8_t value = *((uint8_t*)(node + NODE_TYPE_OFFSET));
+    return (NodeType)value;
+}
+
+void set_node_type(void* node, NodeType type){
+    uint8_t value = type;
+    *((uint8_t*)(node+NODE_TYPE_OFFSET)) = value;
+}
+void initialize_leaf_node(void* node){
+    set_node_type(node,NODE_LEAF);
+    set_node_root(node,false);
+    uint32_t* num_cells_offset = leaf_node_num_cells(node);
+    *num_cells_offset = 0;
+}
+/*
+    Internal Node Header Layout
+*/
+const uint32_t INTERNAL_NODE_NUM_KEYS_SIZE = sizeof(uint32_t); //4
+const uint32_t INTERNAL_NODE_NUM_KEYS_OFFSET = COMMON_NODE_HEADER_SIZE;
+const uint32_t INTERNAL_NODE_RIGHT_CHILD_SIZE = sizeof(uint32_t); // 4
+const uint32_t INTERNAL_NODE_RIGHT_CHILD_OFFSET = 
+                INTERNAL_NODE_NUM_KEYS_OFFSET+INTERNAL_NODE_NUM_KEYS_SIZE;
+const uint32_t INTERNAL_NODE_HEADER_SIZE = COMMON_NODE_HEADER_SIZE+
+                                            INTERNAL_NODE_NUM_KEYS_SIZE+
+                                            INTERNAL_NODE_RIGHT_CHILD_SIZE;
+
+/* Internal Node Body Layout*/
+const uint32_t INTERNAL_NODE_NUM_KEY_SIZE = sizeof(uint32_t); //4
+const uint32_t INTERNAL_NODE_CHILD_SIZE = sizeof(uint32_t); //4
+const uint32_t INTERNAL_NODE_CELL_SIZE = 
+                //key+child pointer
+                INTERNAL_NODE_CHILD_SIZE + INTERNAL_NODE_NUM_KEY_SIZE;
+
+uint32_t* internal_node_num_keys(void* node){
+    return node+INTERNAL_NODE_NUM_KEYS_OFFSET;
+}
+
+uint32_t* internal_node_right_child(void* node){
+    return node+INTERNAL_NODE_RIGHT_CHILD_OFFSET;
+}
+
+uint32_t* internal_node_cell(void* node, uint32_t cell_num){
+    return node+INTERNAL_NODE_HEADER_SIZE + cell_num*INTERNAL_NODE_CELL_SIZE;
+}
+
+uint32_t* internal_node_child(void* node, uint32_t child_num){
+    uint32_t num_keys = *internal_node_num_keys(node);
+    if(child_num > num_keys){
+        printf("Tried to access child_num %d > num_keys %d",child_num,num_keys);
+        exit(EXIT_FAILURE);
+    }else if(child_num == num_keys){
+        return internal_node_right_child(node);
+    }else{
+        return internal_node_cell(node,child_num);
+    }
+}
+
+uint32_t* internal_node_key(void* node, uint32_t key_num){
+    return internal_node_cell(node, key_num) + INTERNAL_NODE_CHILD_SIZE;
+}
+
+void initialize_internal_node(void* node){
+    set_node_type(node, NODE_INTERNAL);
+    set_node_root(node, false);
+    *internal_node_num_keys(node) = 0;
+}
+
+/*Internal node- max key = right key
+Leaf node- max key = at the maximum index*/
+uint32_t get_node_max_key(void* node){
+    switch(get_node_type(node)){
+        case NODE_INTERNAL:
+            return *internal_node_key(node,*internal_node_num_keys(node)-1);
+        case NODE_LEAF:
+            return *leaf_node_key(node,*leaf_node_num_cells(node)-1);
+    }
+}
+
+/*Page compression*/
+/* Rows are fixed width, so most of a page is the zero padding of
+username and email. When enabled, pager_flush() compresses each page
+with a small zero-run codec and get_page() expands it again on a miss.
+Pages in the cache are always uncompressed.
+A compressed page still lives in its slot at page_num*PAGE_SIZE,
+it just uses fewer bytes of it.
+
+Compressed page layout:
+    marker (1 byte) | compressed length (2 bytes) | tokens
+Token layout:
+    literal length (2 bytes) | zero run length (2 bytes) | literal bytes
+The marker can't be confused with a node type (0 or 1) at offset 0.*/
+const uint8_t COMPRESSED_PAGE_MARKER = 0xC5;
+const uint32_t COMPRESSED_PAGE_LENGTH_OFFSET = sizeof(uint8_t);
+const uint32_t COMPRESSED_PAGE_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint16_t);
+const uint32_t COMPRESSION_TOKEN_HEADER_SIZE = 2*sizeof(uint16_t);
+//shorter zero runs cost more in token headers than they save
+const uint32_t COMPRESSION_MIN_ZERO_RUN = 8;
+
+/*Returns the compressed size, or 0 if the page doesn't get smaller.
+destination must have room for PAGE_SIZE bytes.*/
+uint32_t compress_page(void* source, void* destination){
+    uint8_t* in = source;
+    uint8_t* out = destination;
+    uint32_t out_pos = COMPRESSED_PAGE_HEADER_SIZE;
+    uint32_t pos = 0;
+
+    while(pos < PAGE_SIZE){
+        //literal bytes run until a long enough zero run starts
+        uint32_t literal_start = pos;
+        uint32_t zero_run = 0;
+        while(pos < PAGE_SIZE){
+            if(in[pos] != 0){
+                pos++;
+                continue;
+            }
+            zero_run = 0;
+            while(pos+zero_run < PAGE_SIZE && in[pos+zero_run] == 0){
+                zero_run++;
+            }
+            if(zero_run >= COMPRESSION_MIN_ZERO_RUN || pos+zero_run == PAGE_SIZE){
+                break;
+            }
+            pos += zero_run;
+            zero_run = 0;
+        }
+        uint16_t literal_length = pos - literal_start;
+        uint16_t zero_length = zero_run;
+
+        if(out_pos + COMPRESSION_TOKEN_HEADER_SIZE + literal_length >= PAGE_SIZE){
+            return 0;
+        }
+        memcpy(out+out_pos, &literal_length, sizeof(uint16_t));
+        memcpy(out+out_pos+sizeof(uint16_t), &zero_length, sizeof(uint16_t));
+        out_pos += COMPRESSION_TOKEN_HEADER_SIZE;
+        memcpy(out+out_pos, in+literal_start, literal_length);
+        out_pos += literal_length;
+        pos += zero_run;
+    }
+
+    uint16_t compressed_length = out_pos;
+    out[0] = COMPRESSED_PAGE_MARKER;
+    memcpy(out+COMPRESSED_PAGE_LENGTH_OFFSET, &compressed_length, sizeof(uint16_t));
+    return out_pos;
+}
+
+/*Expands a compressed page of at most length bytes into a full page*/
+void decompress_page(void* source, uint32_t length, void* destination){
+    uint8_t* in = source;
+    uint8_t* out = destination;
+    uint16_t compressed_length;
+    memcpy(&compressed_length, in+COMPRESSED_PAGE_LENGTH_OFFSET, sizeof(uint16_t));
+    if(compressed_length > length){
+        printf("Compressed page is truncated. Corrupt file.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t in_pos = COMPRESSED_PAGE_HEADER_SIZE;
+    uint32_t out_pos = 0;
+    while(in_pos < compressed_length){
+        uint16_t literal_length, zero_length;
+        memcpy(&literal_length, in+in_pos, sizeof(uint16_t));
+        memcpy(&zero_length, in+in_pos+sizeof(uint16_t), sizeof(uint16_t));
+        in_pos += COMPRESSION_TOKEN_HEADER_SIZE;
+        if(in_pos + literal_length > compressed_length ||
+            out_pos + literal_length + zero_length > PAGE_SIZE){
+            printf("Bad compressed page. Corrupt file.\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(out+out_pos, in+in_pos, literal_length);
+        in_pos += literal_length;
+        out_pos += literal_length;
+        memset(out+out_pos, 0, zero_length);
+        out_pos += zero_length;
+    }
+    if(out_pos != PAGE_SIZE){
+        printf("Bad compressed page. Corrupt file.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*Performance statistics*/
+uint32_t latency_bucket(uint64_t value){
+    if(value < LATENCY_SUB_BUCKETS){
+        return value;
+    }
+    uint32_t exponent = 63 - __builtin_clzll(value); //position of the highest set bit
+    uint32_t shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    uint32_t sub_bucket = (value >> shift) & (LATENCY_SUB_BUCKETS-1);
+    return (shift+1)*LATENCY_SUB_BUCKETS + sub_bucket;
+}
+
+//largest value that falls in the bucket
+uint64_t latency_bucket_limit(uint32_t bucket){
+    if(bucket < LATENCY_SUB_BUCKETS){
+        return bucket;
+    }
+    uint32_t shift = bucket/LATENCY_SUB_BUCKETS - 1;
+    uint64_t sub_bucket = bucket%LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS;
+    return ((sub_bucket+1) << shift) - 1;
+}
+
+void latency_record(LatencyHistogram* histogram, uint64_t value){
+    histogram->counts[latency_bucket(value)] += 1;
+    histogram->total_count += 1;
+    if(value > histogram->max){
+        histogram->max = value;
+    }
+}
+
+/*percentile between 0 and 100*/
+uint64_t latency_percentile(LatencyHistogram* histogram, double percentile){
+    if(histogram->total_count == 0){
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(percentile/100.0*histogram->total_count + 0.5);
+    if(rank == 0){
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for(uint32_t i = 0; i < LATENCY_BUCKETS; i++){
+        seen += histogram->counts[i];
+        if(seen >= rank){
+            uint64_t limit = latency_bucket_limit(i);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+/*Tracing*/
+/* One ring buffer for the whole process. Tracepoints can fire on several
+threads at once (the bench readers), so slots are claimed off an atomic counter.*/
+#ifdef DB_TRACE
+typedef struct{
+    atomic_bool enabled;
+    atomic_uint_fast64_t next_event; //total events recorded, the slot is this mod TRACE_BUFFER_SIZE
+    TraceEvent events[TRACE_BUFFER_SIZE];
+    FILE* output;
+}Tracer;
+
+Tracer tracer;
+
+const char* TRACE_EVENT_NAMES[] = {
+    "page_read", "page_write", "node_split", "tree_descent", "statement", "output"
+};
+#endif
+
+bool trace_start(const char* path){
+#ifdef DB_TRACE
+    if(trace_enabled()){
+        trace_stop();
+    }
+    tracer.output = fopen(path, "w");
+    if(tracer.output == NULL){
+        return false;
+    }
+    atomic_store(&tracer.next_event, 0);
+    atomic_store(&tracer.enabled, true);
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+uint64_t trace_stop(){
+#ifdef DB_TRACE
+    if(!trace_enabled()){
+        return 0;
+    }
+    atomic_store(&tracer.enabled, false);
+    uint64_t end = atomic_load(&tracer.next_event);
+    uint64_t start = end > TRACE_BUFFER_SIZE ? end-TRACE_BUFFER_SIZE : 0;
+    fprintf(tracer.output, "# start_ns duration_ns event arg\n");
+    for(uint64_t i = start; i < end; i++){
+        TraceEvent* event = &tracer.events[i & (TRACE_BUFFER_SIZE-1)];
+        fprintf(tracer.output, "%llu %llu %s %u\n", (unsigned long long)event->start_ns,
+                (unsigned long long)event->duration_ns, TRACE_EVENT_NAMES[event->type], event->arg);
+    }
+    fclose(tracer.output);
+    tracer.output = NULL;
+    return end-start;
+#else
+    return 0;
+#endif
+}
+
+bool trace_enabled(){
+#ifdef DB_TRACE
+    return atomic_load_explicit(&tracer.enabled, memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+void trace_record(TraceEventType type, uint64_t start_ns, uint64_t duration_ns, uint32_t arg){
+#ifdef DB_TRACE
+    uint64_t slot = atomic_fetch_add_explicit(&tracer.next_event, 1, memory_order_relaxed);
+    TraceEvent* event = &tracer.events[slot & (TRACE_BUFFER_SIZE-1)];
+    event->start_ns = start_ns;
+    event->duration_ns = duration_ns;
+    event->type = type;
+    event->arg = arg;
+#else
+    (void)type;
+    (void)start_ns;
+    (void)duration_ns;
+    (void)arg;
+#endif
+}
+
+
+// Cursor* table_end(Table* table){
+//     Cursor* cursor = malloc(sizeof(Cursor));
+//     cursor->table = table;
+//     // cursor->row_num = table->num_rows;
+//     cursor->page_num = table->root_page_num;
+
+//     void* root_node = get_page(table->pager, table->root_page_num);
+//     uint32_t num_cells = *leaf_node_num_cells(root_node);
+//     cursor->cell_num = num_cells;
+//     cursor->end_of_table = true;
+//     return cursor;
+// }
+
+/*Return the position of the given key.
+If they  key is not present, return the positino
+where it should be inserted.
+*/
+void leaf_node_find(Table* table, uint32_t page_num, uint32_t key, Cursor* cursor){
+    void* node = get_page(table->pager,page_num);
+    uint32_t num_cells = *leaf_node_num_cells(node);
+
+    cursor->table = table;
+    cursor->page_num = page_num;
+    cursor->end_of_table = false;
+
+    //Binary search
+    uint32_t min_index = 0;
+    uint32_t one_past_max_index = num_cells;
+    while(one_past_max_index!=min_index){
+        uint32_t index =(min_index + one_past_max_index)/2;
+        uint32_t key_at_index = *leaf_node_key(node,index);
+        
+        if(key == key_at_index){
+            cursor->cell_num = index;
+            return;
+        }else if(key_at_index>key){
+            one_past_max_index = index;
+        }else{
+            min_index = index+1;
+        }
+        
+    }
+    cursor->cell_num = min_index;
+}
+
+/*Walks down from page_num to the leaf the key belongs in*/
+void internal_node_find(Table* table, uint32_t page_num, uint32_t key, Cursor* cursor){
+    void* node = get_page(table->pager, page_num);
+    while(get_node_type(node) == NODE_INTERNAL){
+        uint32_t num_keys =  *internal_node_num_keys(node);
+
+        /*Binary search to find index of child to search*/
+        uint32_t min_index = 0;
+        uint32_t max_index = num_keys; //total pointers = no.of keys+1
+
+        while(min_index!=max_index){
+            uint32_t index = (min_index+max_index)/2;
+            uint32_t key_to_right = *internal_node_key(node,index);
+            if(key_to_right >=key){
+                max_index = index;
+            }else{
+                min_index = index+1;
+            }
+        }
+        page_num = *internal_node_child(node,min_index);
+        node = get_page(table->pager, page_num);
+    }
+    leaf_node_find(table,page_num,key,cursor);
+}
+
+void table_find(Table* table, uint32_t key, Cursor* cursor){
+    TRACE_BEGIN(trace_start_ns);
+    uint32_t root_page_num = table->root_page_num;
+    void* root_node = get_page(table->pager, root_page_num);
+
+    if(get_node_type(root_node)==NODE_LEAF){
+        leaf_node_find(table,root_page_num,key,cursor);
+    }else{
+        // printf("%d",get_node_type(root_node));
+        // printf("Need to implement searching an internal node\n");
+        // exit(EXIT_FAILURE);
+        internal_node_find(table,root_page_num,key,cursor);
+    }
+    TRACE_END(trace_start_ns, TRACE_TREE_DESCENT, key);
+}
+
+bool cursor_at_key(Cursor* cursor, uint32_t key){
+    void* node = get_page(cursor->table->pager, cursor->page_num);
+    return cursor->cell_num < *leaf_node_num_cells(node) &&
+            *leaf_node_key(node, cursor->cell_num) == key;
+}
+
+/*Exact match: goes straight to the leaf through the hash index if
+there is one, instead of descending the tree. Returns whether key is there.
+The tree has the final say, a key the index misses is looked up there too.*/
+bool table_lookup(Table* table, uint32_t key, Cursor* cursor){
+    uint32_t leaf_page_num;
+    if(table->hash_index != NULL && hash_index_find(table->hash_index, key, &leaf_page_num) &&
+        leaf_page_num < table->pager->num_pages &&
+        get_node_type(get_page(table->pager, leaf_page_num)) == NODE_LEAF){
+        leaf_node_find(table, leaf_page_num, key, cursor);
+        if(cursor_at_key(cursor, key)){
+            return true;
+        }
+    }
+    table_find(table, key, cursor);
+    return cursor_at_key(cursor, key);
+}
+
+/*Follows the first (or last) child pointer down to a leaf.
+Gives the smallest (or largest) key in O(height) page reads.*/
+void* table_edge_leaf(Table* table, bool rightmost){
+    void* node = get_page(table->pager, table->root_page_num);
+    while(get_node_type(node) == NODE_INTERNAL){
+        uint32_t child_num = rightmost ? *internal_node_right_child(node)
+                                        : *internal_node_child(node,0);
+        node = get_page(table->pager, child_num);
+    }
+    return node;
+}
+
+/*Sums leaf cell counts, only node headers are read*/
+uint32_t count_subtree(Table* table, uint32_t page_num){
+    void* node = get_page(table->pager, page_num);
+    if(get_node_type(node) == NODE_LEAF){
+        return *leaf_node_num_cells(node);
+    }
+    uint32_t count = 0;
+    for(uint32_t i = 0; i <= *internal_node_num_keys(node); i++){
+        count += count_subtree(table, *internal_node_child(node,i));
+    }
+    return count;
+}
+
+/*Sums the keys (= ids) straight out of the leaf cells,
+rows are never deserialized*/
+uint64_t sum_subtree_keys(Table* table, uint32_t page_num){
+    void* node = get_page(table->pager, page_num);
+    uint64_t sum = 0;
+    if(get_node_type(node) == NODE_LEAF){
+        uint32_t num_cells = *leaf_node_num_cells(node);
+        for(uint32_t i = 0; i < num_cells; i++){
+            sum += *leaf_node_key(node,i);
+        }
+        return sum;
+    }
+    for(uint32_t i = 0; i <= *internal_node_num_keys(node); i++){
+        sum += sum_subtree_keys(table, *internal_node_child(node,i));
+    }
+    return sum;
+}
+
+void* cursor_value(Cursor* cursor){
+    uint32_t page_num = cursor->page_num;
+    void* page = get_page(cursor->table->pager,page_num);
+    // uint32_t row_offset = row_num % ROWS_PER_PAGE;
+    // uint32_t byte_offset = row_offset * ROW_SIZE;
+    // return page + byte_offset;
+    return leaf_node_value(page,cursor->cell_num);
+}
+
+/*new page retrieved from the end of database file*/
+uint32_t get_unused_page_num(Pager* pager){
+    return pager->num_pages;
+}
+
+const uint32_t LEAF_NODE_RIGHT_SPLIT_COUNT = (LEAF_NODE_MAX_CELLS+1)/2;
+const uint32_t LEAF_NODE_LEFT_SPLIT_COUNT = 
+    (LEAF_NODE_MAX_CELLS+1)-LEAF_NODE_RIGHT_SPLIT_COUNT;
+
+
+/* In SQLite:
+Let N be the root node. Allocate two nodes, L and R.
+Move lower half of N into L and upper half of N into R.
+Now N is empty. ADD <L,K,R> where K is the max key in L.
+Page N remains the root.*/
+
+void create_new_root(Table* table,uint32_t right_child_page_num){
+    /*
+    Handle splitting the root.
+    Old root copied to new page, becomes left child.
+    Address of right child passed in.
+    Re-initiliaze root page to contain the new root node.
+    New root node points to two children.*/
+    table->root_splits += 1;
+    void* root = get_page(table->pager,table->root_page_num); //old root (now left child)
+    void* right_child = get_page(table->pager,right_child_page_num);
+    
+    uint32_t left_child_page_num = get_unused_page_num(table->pager);
+    void* left_child = get_page(table->pager, left_child_page_num);
+    /*copy root data to left_child*/
+    memcpy(left_child,root,PAGE_SIZE);
+    set_node_root(left_child,false);
+    
+    /*Root node is a new internal node with one key and two children*/
+    initialize_internal_node(root);
+    set_node_root(root,true);
+    *internal_node_num_keys(root) = 1;
+    *internal_node_child(root,0) = left_child_page_num;
+    uint32_t left_child_max_key = get_node_max_key(left_child);
+    *internal_node_key(root,0) = left_child_max_key;
+    *internal_node_right_child(root) = right_child_page_num;
+    pager_mark_dirty(table->pager, table->root_page_num);
+    pager_mark_dirty(table->pager, left_child_page_num);
+    //every key of the old root moved to the left child
+    if(get_node_type(left_child) == NODE_LEAF){
+        hash_index_leaf(table, left_child_page_num);
+    }
+}
+void leaf_node_split_and_insert(Cursor* cursor, uint32_t key, Row* value){
+    /*Create a new node and move half the cells over
+    Insert the new value in one of the two nodes
+    Update parent or create a parent*/
+
+    TRACE_BEGIN(trace_start_ns);
+    cursor->table->leaf_splits += 1;
+    void* old_node = get_page(cursor->table->pager,cursor->page_num);
+    uint32_t new_page_num = get_unused_page_num(cursor->table->pager);
+    void* new_node = get_page(cursor->table->pager,new_page_num);
+    initialize_leaf_node(new_node);
+    
+    /*All existing keys plus new key should be divided evenly
+    b/w old(left) and new(right) nodes.
+    Starting from the right, move each key to correct
+    position.*/
+    /* don't use uint32_t here */
+    for(int32_t i = LEAF_NODE_MAX_CELLS; i>=0;i--){
+        // printf("%d - yayaya ", i);
+        if(i == -1){
+            // printf("\n\nNOOOOOOOO\n\n");
+        }
+        void* destination_node;
+        if(i>=LEAF_NODE_LEFT_SPLIT_COUNT){
+            destination_node = new_node;
+        }else{
+            destination_node = old_node;
+        }
+        uint32_t index_within_node = i%LEAF_NODE_LEFT_SPLIT_COUNT;
+        void* destination = leaf_node_cell(destination_node,index_within_node);
+
+        if(i == cursor->cell_num){
+            //the new cell
+            *leaf_node_key(destination_node,index_within_node) = key;
+            serialize_row(value,leaf_node_value(destination_node,index_within_node));
+        }else if(i>cursor->cell_num){
+            //the cells that come after the new cell
+            memcpy(destination,leaf_node_cell(old_node,i-1),LEAF_NODE_CELL_SIZE);
+        }else{
+            //the cells before the new cell
+            memcpy(destination,leaf_node_cell(old_node,i),LEAF_NODE_CELL_SIZE);
+        }
+    }
+    /* Update cell count on both leaf node*/
+    *(leaf_node_num_cells(old_node)) = LEAF_NODE_LEFT_SPLIT_COUNT;
+    *(leaf_node_num_cells(new_node)) = LEAF_NODE_RIGHT_SPLIT_COUNT;
+    pager_mark_dirty(cursor->table->pager, cursor->page_num);
+    pager_mark_dirty(cursor->table->pager, new_page_num);
+    hash_index_leaf(cursor->table, new_page_num);
+    
+    /*Create Parent*/
+    if(is_node_root(old_node)){
+        create_new_root(cursor->table,new_page_num);
+        TRACE_END(trace_start_ns, TRACE_NODE_SPLIT, cursor->page_num);
+    }else{
+        printf("Need to implement updating parent after split\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+void leaf_node_insert(Cursor* cursor, uint32_t key, Row* value){
+    void* node = get_page(cursor->table->pager,cursor->page_num);
+
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    if(num_cells>=LEAF_NODE_MAX_CELLS){
+        //Node full
+        // printf("Need to implement splitting of a leaf node.\n");
+        // exit(EXIT_FAILURE);
+        leaf_node_split_and_insert(cursor,key,value);
+        return;
+    }
+
+    if(cursor->cell_num < num_cells){
+        //Insert row at pos cell_num
+        //shift all the following cells to the right
+        for(uint32_t i = num_cells; i>cursor->cell_num; i--){
+            memcpy(leaf_node_cell(node,i),leaf_node_cell(node,i-1),LEAF_NODE_CELL_SIZE);
+        }
+    }
+    //now insert into cell_num
+    *(leaf_node_num_cells(node)) += 1;
+    *(leaf_node_key(node,cursor->cell_num)) = key;
+    serialize_row(value,leaf_node_value(node,cursor->cell_num));
+    pager_mark_dirty(cursor->table->pager, cursor->page_num);
+    if(cursor->table->hash_index != NULL){
+        hash_index_put(cursor->table->hash_index, key, cursor->page_num);
+    }
+}
+
+/*Hash index*/
+/* An extendible hash index on id, kept in its own file next to the
+database and read through its own pager. It maps a key to the leaf
+page holding it, so an exact lookup reads the index header, one bucket
+and the leaf, however tall the tree is. Cell numbers aren't stored:
+they shift on every insert, leaf pages only change on a split.
+
+Page 0 is the header: magic | global depth | no. of keys | clean |
+db stamp | directory, directory entry i is the bucket page for keys whose
+hash ends in the global depth's low bits i. Opening clears clean on disk
+and closing sets it again, after the database and every other index page
+are written, along with the stamp: the database file's device, inode and
+size. An index that isn't clean or whose stamp doesn't match the database
+(a crash, or an index left next to a different database) is rebuilt.
+Every other page is a bucket:
+local depth | no. of entries | entries (key, leaf page num).
+A full bucket splits in two on its next hash bit, doubling the
+directory first if the bucket already uses every directory bit.*/
+const uint32_t HASH_INDEX_MAGIC = 0x4853445A; //changes with the header layout
+const uint32_t HASH_INDEX_MAGIC_OFFSET = 0;
+const uint32_t HASH_INDEX_GLOBAL_DEPTH_OFFSET = 4;
+const uint32_t HASH_INDEX_NUM_KEYS_OFFSET = 8;
+const uint32_t HASH_INDEX_CLEAN_OFFSET = 12;
+const uint32_t HASH_INDEX_DB_STAMP_OFFSET = 16; //uint64 device, inode, size
+const uint32_t HASH_INDEX_DIRECTORY_OFFSET = 40;
+#define HASH_INDEX_MAX_GLOBAL_DEPTH 9 //512 directory entries fit in the header page
+const uint32_t HASH_BUCKET_LOCAL_DEPTH_OFFSET = 0;
+const uint32_t HASH_BUCKET_NUM_ENTRIES_OFFSET = 4;
+const uint32_t HASH_BUCKET_HEADER_SIZE = 8;
+const uint32_t HASH_BUCKET_ENTRY_SIZE = 8; //key, leaf page num
+#define HASH_BUCKET_MAX_ENTRIES ((PAGE_SIZE-HASH_BUCKET_HEADER_SIZE)/HASH_BUCKET_ENTRY_SIZE)
+
+uint32_t* hash_index_field(void* page, uint32_t offset){
+    return (uint32_t*)((uint8_t*)page + offset);
+}
+
+uint32_t* hash_index_directory(void* header, uint32_t index){
+    return hash_index_field(header, HASH_INDEX_DIRECTORY_OFFSET + index*sizeof(uint32_t));
+}
+
+uint32_t* hash_bucket_key(void* bucket, uint32_t entry){
+    return hash_index_field(bucket, HASH_BUCKET_HEADER_SIZE + entry*HASH_BUCKET_ENTRY_SIZE);
+}
+
+uint32_t* hash_bucket_leaf(void* bucket, uint32_t entry){
+    return hash_bucket_key(bucket, entry) + 1;
+}
+
+//ids are often sequential, mix them so the low bits spread (murmur3 finalizer)
+uint32_t hash_key(uint32_t key){
+    key ^= key >> 16;
+    key *= 0x85ebca6b;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35;
+    key ^= key >> 16;
+    return key;
+}
+
+void initialize_hash_bucket(void* bucket, uint32_t local_depth){
+    *hash_index_field(bucket, HASH_BUCKET_LOCAL_DEPTH_OFFSET) = local_depth;
+    *hash_index_field(bucket, HASH_BUCKET_NUM_ENTRIES_OFFSET) = 0;
+}
+
+/*An empty index: global depth 0, one bucket*/
+void hash_index_init(Pager* index){
+    void* header = get_page(index, 0);
+    *hash_index_field(header, HASH_INDEX_MAGIC_OFFSET) = HASH_INDEX_MAGIC;
+    *hash_index_field(header, HASH_INDEX_GLOBAL_DEPTH_OFFSET) = 0;
+    *hash_index_field(header, HASH_INDEX_NUM_KEYS_OFFSET) = 0;
+    *hash_index_field(header, HASH_INDEX_CLEAN_OFFSET) = 0;
+    memset((uint8_t*)header + HASH_INDEX_DB_STAMP_OFFSET, 0,
+            HASH_INDEX_DIRECTORY_OFFSET - HASH_INDEX_DB_STAMP_OFFSET);
+    uint32_t bucket_page_num = get_unused_page_num(index);
+    *hash_index_directory(header, 0) = bucket_page_num;
+    initialize_hash_bucket(get_page(index, bucket_page_num), 0);
+}
+
+void* hash_index_bucket(Pager* index, uint32_t hash){
+    void* header = get_page(index, 0);
+    uint32_t global_depth = *hash_index_field(header, HASH_INDEX_GLOBAL_DEPTH_OFFSET);
+    uint32_t directory_index = hash & ((1u << global_depth)-1);
+    return get_page(index, *hash_index_directory(header, directory_index));
+}
+
+bool hash_index_find(Pager* index, uint32_t key, uint32_t* leaf_page_num){
+    void* bucket = hash_index_bucket(index, hash_key(key));
+    uint32_t num_entries = *hash_index_field(bucket, HASH_BUCKET_NUM_ENTRIES_OFFSET);
+    for(uint32_t i = 0; i < num_entries; i++){
+        if(*hash_bucket_key(bucket, i) == key){
+            *leaf_page_num = *hash_bucket_leaf(bucket, i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*Splits the bucket at directory_index on its next hash bit*/
+void hash_index_split_bucket(Pager* index, uint32_t directory_index){
+    void* header = get_page(index, 0);
+    uint32_t* global_depth = hash_index_field(header, HASH_INDEX_GLOBAL_DEPTH_OFFSET);
+    uint32_t old_page_num = *hash_index_directory(header, directory_index);
+    void* old_bucket = get_page(index, old_page_num);
+    uint32_t local_depth = *hash_index_field(old_bucket, HASH_BUCKET_LOCAL_DEPTH_OFFSET);
+
+    if(local_depth == *global_depth){
+        if(*global_depth == HASH_INDEX_MAX_GLOBAL_DEPTH){
+            printf("Error: Hash index full.\n");
+            exit(EXIT_FAILURE);
+        }
+        //double the directory, the new half points where the old half does
+        uint32_t size = 1u << *global_depth;
+        for(uint32_t i = 0; i < size; i++){
+            *hash_index_directory(header, size+i) = *hash_index_directory(header, i);
+        }
+        *global_depth += 1;
+    }
+
+    uint32_t new_page_num = get_unused_page_num(index);
+    void* new_bucket = get_page(index, new_page_num);
+    initialize_hash_bucket(new_bucket, local_depth+1);
+    *hash_index_field(old_bucket, HASH_BUCKET_LOCAL_DEPTH_OFFSET) = local_depth+1;
+
+    //entries with the new bit set move to the new bucket
+    uint32_t bit = 1u << local_depth;
+    uint32_t* old_num_entries = hash_index_field(old_bucket, HASH_BUCKET_NUM_ENTRIES_OFFSET);
+    uint32_t* new_num_entries = hash_index_field(new_bucket, HASH_BUCKET_NUM_ENTRIES_OFFSET);
+    uint32_t kept = 0;
+    for(uint32_t i = 0; i < *old_num_entries; i++){
+        uint32_t key = *hash_bucket_key(old_bucket, i);
+        uint32_t leaf_page_num = *hash_bucket_leaf(old_bucket, i);
+        bool moves = hash_key(key) & bit;
+        void* bucket = moves ? new_bucket : old_bucket;
+        uint32_t entry = moves ? (*new_num_entries)++ : kept++;
+        *hash_bucket_key(bucket, entry) = key;
+        *hash_bucket_leaf(bucket, entry) = leaf_page_num;
+    }
+    *old_num_entries = kept;
+
+    for(uint32_t i = 0; i < (1u << *global_depth); i++){
+        if(*hash_index_directory(header, i) == old_page_num && (i & bit)){
+            *hash_index_directory(header, i) = new_page_num;
+        }
+    }
+}
+
+/*Adds key, or points it at a new leaf if it's already there*/
+void hash_index_put(Pager* index, uint32_t key, uint32_t leaf_page_num){
+    uint32_t hash = hash_key(key);
+    while(true){
+        void* bucket = hash_index_bucket(index, hash);
+        uint32_t* num_entries = hash_index_field(bucket, HASH_BUCKET_NUM_ENTRIES_OFFSET);
+        for(uint32_t i = 0; i < *num_entries; i++){
+            if(*hash_bucket_key(bucket, i) == key){
+                *hash_bucket_leaf(bucket, i) = leaf_page_num;
+                return;
+            }
+        }
+        if(*num_entries < HASH_BUCKET_MAX_ENTRIES){
+            *hash_bucket_key(bucket, *num_entries) = key;
+            *hash_bucket_leaf(bucket, *num_entries) = leaf_page_num;
+            *num_entries += 1;
+            void* header = get_page(index, 0);
+            *hash_index_field(header, HASH_INDEX_NUM_KEYS_OFFSET) += 1;
+            return;
+        }
+        void* header = get_page(index, 0);
+        uint32_t global_depth = *hash_index_field(header, HASH_INDEX_GLOBAL_DEPTH_OFFSET);
+        hash_index_split_bucket(index, hash & ((1u << global_depth)-1));
+    }
+}
+
+/*Points every key in the leaf at it, after cells moved there*/
+void hash_index_leaf(Table* table, uint32_t page_num){
+    if(table->hash_index == NULL){
+        return;
+    }
+    void* node = get_page(table->pager, page_num);
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    for(uint32_t i = 0; i < num_cells; i++){
+        hash_index_put(table->hash_index, *leaf_node_key(node,i), page_num);
+    }
+}
+
+void hash_index_subtree(Table* table, uint32_t page_num){
+    void* node = get_page(table->pager, page_num);
+    if(get_node_type(node) == NODE_LEAF){
+        hash_index_leaf(table, page_num);
+        return;
+    }
+    for(uint32_t i = 0; i <= *internal_node_num_keys(node); i++){
+        hash_index_subtree(table, *internal_node_child(node,i));
+    }
+}
+
+/*Throws away any existing index file and indexes every key in the tree*/
+void db_create_hash_index(Table* table){
+    db_drop_hash_index(table);
+    table->hash_index = pager_open(table->hash_index_path, table->pager->direct_io);
+    hash_index_init(table->hash_index);
+    hash_index_subtree(table, table->root_page_num);
+}
+
+void db_drop_hash_index(Table* table){
+    if(table->hash_index != NULL){
+        pager_close(table->hash_index);
+        table->hash_index = NULL;
+    }
+    unlink(table->hash_index_path);
+}
+
+void hash_index_stamp(void* header, struct stat* db_stat, uint64_t db_size){
+    uint64_t stamp[3] = {db_stat->st_dev, db_stat->st_ino, db_size};
+    memcpy((uint8_t*)header + HASH_INDEX_DB_STAMP_OFFSET, stamp, sizeof(stamp));
+}
+
+/*Opens the index if the database has one. Only the header is read:
+the clean flag and the stamp say whether the index was closed along
+with this database, otherwise it's rebuilt. A stale index that slips
+through (a same-sized database copied over this one) only costs
+lookups their shortcut, table_lookup() checks every leaf it's sent to.*/
+void open_hash_index(Table* table){
+    struct stat index_stat;
+    if(stat(table->hash_index_path, &index_stat) != 0){
+        return;
+    }
+    //pager_open() refuses a torn file, the index can always be rebuilt though
+    if(index_stat.st_size < 2*PAGE_SIZE || index_stat.st_size % PAGE_SIZE != 0){
+        db_create_hash_index(table);
+        return;
+    }
+    table->hash_index = pager_open(table->hash_index_path, table->pager->direct_io);
+    void* header = get_page(table->hash_index, 0);
+    struct stat db_stat;
+    if(fstat(table->pager->file_descriptor, &db_stat) == -1){
+        pager_io_error("reading db file size");
+    }
+    uint8_t stamp[HASH_INDEX_DIRECTORY_OFFSET];
+    hash_index_stamp(stamp, &db_stat, db_stat.st_size);
+    bool valid = *hash_index_field(header, HASH_INDEX_MAGIC_OFFSET) == HASH_INDEX_MAGIC &&
+                *hash_index_field(header, HASH_INDEX_CLEAN_OFFSET) == 1 &&
+                !memcmp((uint8_t*)header + HASH_INDEX_DB_STAMP_OFFSET, stamp + HASH_INDEX_DB_STAMP_OFFSET,
+                        HASH_INDEX_DIRECTORY_OFFSET - HASH_INDEX_DB_STAMP_OFFSET);
+    if(!valid){
+        //the new index has no pages on disk until db_close()
+        db_create_hash_index(table);
+        return;
+    }
+    //from here on a crash leaves the index looking stale
+    *hash_index_field(header, HASH_INDEX_CLEAN_OFFSET) = 0;
+    pager_flush(table->hash_index, 0);
+}
+
+/*Writes the index out, then marks it clean with the stamp of the
+database it was closed with. db_size is what pager_close() left the
+database at.*/
+void close_hash_index(Table* table, struct stat* db_stat, uint64_t db_size){
+    pager_close(table->hash_index);
+    table->hash_index = NULL;
+    uint8_t header[HASH_INDEX_DIRECTORY_OFFSET];
+    *hash_index_field(header, HASH_INDEX_CLEAN_OFFSET) = 1;
+    hash_index_stamp(header, db_stat, db_size);
+    int fd = open(table->hash_index_path, O_WRONLY);
+    if(fd == -1 ||
+        pwrite(fd, header + HASH_INDEX_CLEAN_OFFSET, HASH_INDEX_DIRECTORY_OFFSET - HASH_INDEX_CLEAN_OFFSET,
+                HASH_INDEX_CLEAN_OFFSET) == -1){
+        pager_io_error("writing hash index");
+    }
+    close(fd);
+}
+
+
+
+
+
+
+const uint32_t INTERNAL_NODE_MAX_CELLS =
+        (PAGE_SIZE - INTERNAL_NODE_HEADER_SIZE)/INTERNAL_NODE_CELL_SIZE;
+
+void collect_level_stats(Pager* pager, uint32_t page_num, uint32_t level,
+                        DbStats* stats, uint64_t* used_cells, uint64_t* cell_capacity){
+    if(level >= STATS_MAX_LEVELS){
+        return;
+    }
+    //the walk leaves the cache and its counters as they were
+    void* frame;
+    void* node = peek_page(pager, page_num, &frame);
+    if(level+1 > stats->tree_height){
+        stats->tree_height = level+1;
+    }
+    stats->nodes_per_level[level] += 1;
+    if(get_node_type(node) == NODE_LEAF){
+        used_cells[level] += *leaf_node_num_cells(node);
+        cell_capacity[level] += LEAF_NODE_MAX_CELLS;
+    }else{
+        uint32_t num_keys = *internal_node_num_keys(node);
+        used_cells[level] += num_keys;
+        cell_capacity[level] += INTERNAL_NODE_MAX_CELLS;
+        for(uint32_t i = 0; i <= num_keys; i++){
+            collect_level_stats(pager, *internal_node_child(node,i), level+1,
+                                stats, used_cells, cell_capacity);
+        }
+    }
+    release_peeked_page(pager, frame);
+}
+
+/*Snapshot of the counters; height and fill factors are computed by
+walking the tree, so this costs a full pass over the internal nodes.*/
+void db_get_stats(Table* table, DbStats* stats){
+    memset(stats, 0, sizeof(DbStats));
+    pthread_mutex_lock(&table->pager->lock);
+    stats->pager = table->pager->stats;
+    pthread_mutex_unlock(&table->pager->lock);
+
+    uint64_t used_cells[STATS_MAX_LEVELS] = {0};
+    uint64_t cell_capacity[STATS_MAX_LEVELS] = {0};
+    collect_level_stats(table->pager, table->root_page_num, 0,
+                        stats, used_cells, cell_capacity);
+    for(uint32_t i = 0; i < stats->tree_height; i++){
+        stats->fill_factor[i] = (double)used_cells[i]/cell_capacity[i];
+    }
+    stats->leaf_splits = table->leaf_splits;
+    stats->root_splits = table->root_splits;
+    for(uint32_t i = 0; i < STATEMENT_TYPE_COUNT; i++){
+        LatencyHistogram* histogram = &table->latency[i];
+        stats->latency[i].count = histogram->total_count;
+        stats->latency[i].p50 = latency_percentile(histogram, 50);
+        stats->latency[i].p99 = latency_percentile(histogram, 99);
+        stats->latency[i].p999 = latency_percentile(histogram, 99.9);
+        stats->latency[i].max = histogram->max;
+    }
+}
+
+/*percentile between 0 and 100, in ns*/
+uint64_t db_latency_percentile(Table* table, StatementType type, double percentile){
+    return latency_percentile(&table->latency[type], percentile);
+}
+
+bool db_set_option(Table* table, DbOption option, uint32_t value){
+    switch(option){
+        case(DB_OPTION_COMPRESS):
+            if(value > 1){
+                return false;
+            }
+            table->pager->compress_pages = value;
+            return true;
+        case(DB_OPTION_SORT_BUDGET):
+            if(value == 0){
+                return false;
+            }
+            table->sort_budget = value;
+            return true;
+    }
+    return false;
+}
+
+/*Debugging output*/
+void indent(uint32_t level){
+    for(uint32_t i = 0; i<level; i++){
+        printf(" ");
+    }
+}
+
+void print_tree(Pager* pager, uint32_t page_num, uint32_t indentation_level){
+    void* node = get_page(pager, page_num);
+    uint32_t num_keys, child;
+
+    switch(get_node_type(node)){
+        case(NODE_LEAF):
+            num_keys = *leaf_node_num_cells(node);
+            indent(indentation_level);
+            printf("- leaf (size %d)\n", num_keys);
+            for(uint32_t i = 0; i<num_keys; i++){
+                indent(indentation_level+1);
+                printf("- %d\n",*leaf_node_key(node,i));
+            }
+            break;
+        case(NODE_INTERNAL):
+            num_keys = *internal_node_num_keys(node);
+            indent(indentation_level);
+            printf("- internal (size %d)\n", num_keys);
+            for(uint32_t i = 0; i<num_keys; i++){
+                child = *internal_node_child(node, i);
+                print_tree(pager,child,indentation_level+1);
+                
+                indent(indentation_level+1);
+                printf("- key %d\n", *internal_node_key(node,i));
+            }
+            child = *internal_node_right_child(node);
+            print_tree(pager,child,indentation_level+1);
+            break;
+    }
+}
+
+void print_leaf_node(void* node){
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    printf("leaf (size %d)\n",num_cells);
+    for (uint32_t i = 0; i<num_cells; i++){
+        uint32_t key = *leaf_node_key(node,i);
+        printf("  - %d : %d\n",i,key);
+    }
+}
+
+void db_print_tree(Table* table){
+    // print_leaf_node(get_page(table->pager,0));
+    print_tree(table->pager,table->root_page_num,0);
+}
+
+void db_print_constants(){
+    printf("ROW_SIZE: %d\n",ROW_SIZE);
+    printf("COMMON_NODE_HEADER_SIZE: %d\n", COMMON_NODE_HEADER_SIZE);
+    printf("LEAF_NODE_HEADER_SIZE: %d\n",LEAF_NODE_HEADER_SIZE);
+    printf("LEAF_NODE_CELL_SIZE: %d\n",LEAF_NODE_CELL_SIZE);
+    printf("LEAF_NODE_SPACE_FOR_CELLS: %d\n", LEAF_NODE_SPACE_FOR_CELLS);
+    printf("LEAF_NODE_MAX_CELLS: %d\n",LEAF_NODE_MAX_CELLS);
+}
+
+
+
+char* row_column_text(Row* row, Column column){
+    return column == COLUMN_USERNAME ? row->username : row->email;
+}
+
+/*ORDER BY / LIMIT / OFFSET*/
+typedef struct{
+    uint32_t to_skip; //offset
+    uint32_t remaining; //limit
+    bool has_limit;
+    RowVisitor emit;
+    void* emit_arg;
+}RowLimiter;
+
+/*Visits rows in key order until visit returns false.
+Returns false if it stopped early.*/
+bool walk_subtree(Table* table, uint32_t page_num, RowVisitor visit, void* arg){
+    void* node = get_page(table->pager, page_num);
+    if(get_node_type(node) == NODE_LEAF){
+        Row row;
+        for(uint32_t i = 0; i < *leaf_node_num_cells(node); i++){
+            deserialize_row(leaf_node_value(node,i), &row);
+            if(!visit(&row, arg)){
+                return false;
+            }
+        }
+        return true;
+    }
+    for(uint32_t i = 0; i <= *internal_node_num_keys(node); i++){
+        if(!walk_subtree(table, *internal_node_child(node,i), visit, arg)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool emit_limited_row(Row* row, void* arg){
+    RowLimiter* limiter = arg;
+    if(limiter->to_skip > 0){
+        limiter->to_skip -= 1;
+        return true;
+    }
+    if(!limiter->emit(row, limiter->emit_arg)){
+        return false;
+    }
+    if(limiter->has_limit){
+        limiter->remaining -= 1;
+        return limiter->remaining > 0;
+    }
+    return true;
+}
+
+/*Ties are broken by id so the order is always the same*/
+int compare_rows(Row* a, Row* b, Column column){
+    int cmp = strcmp(row_column_text(a,column), row_column_text(b,column));
+    if(cmp != 0){
+        return cmp;
+    }
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+/*rows[0] is the largest row of the heap*/
+void heap_sift_down(Row* rows, uint32_t size, uint32_t index, Column column){
+    while(true){
+        uint32_t largest = index;
+        uint32_t left = 2*index+1;
+        uint32_t right = 2*index+2;
+        if(left < size && compare_rows(&rows[left],&rows[largest],column) > 0) largest = left;
+        if(right < size && compare_rows(&rows[right],&rows[largest],column) > 0) largest = right;
+        if(largest == index){
+            return;
+        }
+        Row temp = rows[index];
+        rows[index] = rows[largest];
+        rows[largest] = temp;
+        index = largest;
+    }
+}
+
+void heap_sift_up(Row* rows, uint32_t index, Column column){
+    while(index > 0){
+        uint32_t parent = (index-1)/2;
+        if(compare_rows(&rows[index],&rows[parent],column) <= 0){
+            return;
+        }
+        Row temp = rows[index];
+        rows[index] = rows[parent];
+        rows[parent] = temp;
+        index = parent;
+    }
+}
+
+//in place, no extra memory
+void heap_sort_rows(Row* rows, uint32_t size, Column column){
+    for(uint32_t i = size/2; i > 0; i--){
+        heap_sift_down(rows, size, i-1, column);
+    }
+    for(uint32_t end = size; end > 1; end--){
+        Row temp = rows[0];
+        rows[0] = rows[end-1];
+        rows[end-1] = temp;
+        heap_sift_down(rows, end-1, 0, column);
+    }
+}
+
+/* The sorter never holds more than capacity rows.
+With a small LIMIT it keeps a max heap of the LIMIT+OFFSET smallest rows
+seen so far (top-K). Otherwise it fills its buffer, sorts it and spills it
+to a temp file as a sorted run; the runs are merged at the end, at most
+capacity runs at a time. Merged runs are appended to the same file.*/
+typedef struct{
+    uint32_t start; //row index in the runs file
+    uint32_t length;
+}SortRun;
+
+typedef struct{
+    Column column;
+    Arena* arena; //rows and merge state come from the statement's arena
+    Row* rows;
+    uint32_t capacity;
+    uint32_t num_rows;
+    bool top_k;
+    FILE* runs_file;
+    SortRun* runs;
+    uint32_t num_runs;
+    uint32_t rows_spilled;
+}Sorter;
+
+//appends row to the end of the runs file
+bool append_sort_run_row(Row* row, void* arg){
+    Sorter* sorter = arg;
+    uint8_t buffer[ROW_SIZE];
+    serialize_row(row, buffer);
+    fseek(sorter->runs_file, (long)sorter->rows_spilled*ROW_SIZE, SEEK_SET);
+    if(fwrite(buffer, ROW_SIZE, 1, sorter->runs_file) != 1){
+        printf("Error writing sort file: %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    sorter->rows_spilled += 1;
+    return true;
+}
+
+//the rows appended since start become a run
+void sorter_add_run(Sorter* sorter, uint32_t start){
+    sorter->runs = realloc(sorter->runs, (sorter->num_runs+1)*sizeof(SortRun));
+    sorter->runs[sorter->num_runs].start = start;
+    sorter->runs[sorter->num_runs].length = sorter->rows_spilled - start;
+    sorter->num_runs += 1;
+}
+
+void sorter_spill(Sorter* sorter){
+    if(sorter->runs_file == NULL){
+        sorter->runs_file = tmpfile();
+        if(sorter->runs_file == NULL){
+            printf("Error creating sort file: %d\n", errno);
+            exit(EXIT_FAILURE);
+        }
+    }
+    heap_sort_rows(sorter->rows, sorter->num_rows, sorter->column);
+
+    uint32_t start = sorter->rows_spilled;
+    for(uint32_t i = 0; i < sorter->num_rows; i++){
+        append_sort_run_row(&sorter->rows[i], sorter);
+    }
+    sorter_add_run(sorter, start);
+    sorter->num_rows = 0;
+}
+
+bool sorter_add(Row* row, void* arg){
+    Sorter* sorter = arg;
+    if(sorter->top_k){
+        if(sorter->num_rows < sorter->capacity){
+            sorter->rows[sorter->num_rows] = *row;
+            heap_sift_up(sorter->rows, sorter->num_rows, sorter->column);
+            sorter->num_rows += 1;
+        }else if(compare_rows(row, &sorter->rows[0], sorter->column) < 0){
+            //smaller than the largest row kept, replace it
+            sorter->rows[0] = *row;
+            heap_sift_down(sorter->rows, sorter->num_rows, 0, sorter->column);
+        }
+        return true;
+    }
+    if(sorter->num_rows == sorter->capacity){
+        sorter_spill(sorter);
+    }
+    sorter->rows[sorter->num_rows] = *row;
+    sorter->num_rows += 1;
+    return true;
+}
+
+void read_sort_run_row(Sorter* sorter, uint32_t row_index, Row* row){
+    uint8_t buffer[ROW_SIZE];
+    fseek(sorter->runs_file, (long)row_index*ROW_SIZE, SEEK_SET);
+    if(fread(buffer, ROW_SIZE, 1, sorter->runs_file) != 1){
+        printf("Error reading sort file: %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    deserialize_row(buffer, row);
+}
+
+/*Merge state, one slot per run being merged*/
+typedef struct{
+    uint32_t fan_in; //max runs merged at once
+    Row* heads; //next row of each slot's run
+    uint32_t* next; //index in the run of the row after heads[slot]
+    uint32_t* heap; //slots, min heap on their heads
+}RunMerger;
+
+void run_heap_sift_down(RunMerger* merger, uint32_t size, uint32_t index, Column column){
+    uint32_t* heap = merger->heap;
+    Row* heads = merger->heads;
+    while(true){
+        uint32_t smallest = index;
+        uint32_t left = 2*index+1;
+        uint32_t right = 2*index+2;
+        if(left < size && compare_rows(&heads[heap[left]],&heads[heap[smallest]],column) < 0) smallest = left;
+        if(right < size && compare_rows(&heads[heap[right]],&heads[heap[smallest]],column) < 0) smallest = right;
+        if(smallest == index){
+            return;
+        }
+        uint32_t temp = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = temp;
+        index = smallest;
+    }
+}
+
+/*k-way merge of count runs starting at runs[first], keeps one row per run in memory*/
+void merge_runs(Sorter* sorter, RunMerger* merger, uint32_t first, uint32_t count,
+                RowVisitor visit, void* arg){
+    uint32_t size = 0;
+    for(uint32_t slot = 0; slot < count; slot++){
+        SortRun* run = &sorter->runs[first+slot];
+        if(run->length == 0){
+            continue;
+        }
+        read_sort_run_row(sorter, run->start, &merger->heads[slot]);
+        merger->next[slot] = 1;
+        merger->heap[size] = slot;
+        size += 1;
+    }
+    for(uint32_t i = size/2; i > 0; i--){
+        run_heap_sift_down(merger, size, i-1, sorter->column);
+    }
+
+    while(size > 0){
+        uint32_t slot = merger->heap[0];
+        if(!visit(&merger->heads[slot], arg)){
+            return;
+        }
+        SortRun* run = &sorter->runs[first+slot];
+        if(merger->next[slot] < run->length){
+            read_sort_run_row(sorter, run->start+merger->next[slot], &merger->heads[slot]);
+            merger->next[slot] += 1;
+        }else{
+            //run used up
+            size -= 1;
+            merger->heap[0] = merger->heap[size];
+        }
+        run_heap_sift_down(merger, size, 0, sorter->column);
+    }
+}
+
+/*Merges the runs fan_in at a time until one merge can take the rest*/
+void sorter_merge(Sorter* sorter, RowVisitor visit, void* arg){
+    RunMerger merger;
+    merger.fan_in = sorter->capacity < 2 ? 2 : sorter->capacity;
+    //the row buffer is done with, the heads take its place
+    merger.heads = merger.fan_in <= sorter->capacity ? sorter->rows
+                    : arena_alloc(sorter->arena, merger.fan_in*sizeof(Row));
+    merger.next = arena_alloc(sorter->arena, merger.fan_in*sizeof(uint32_t));
+    merger.heap = arena_alloc(sorter->arena, merger.fan_in*sizeof(uint32_t));
+
+    uint32_t first = 0;
+    while(sorter->num_runs - first > merger.fan_in){
+        uint32_t start = sorter->rows_spilled;
+        merge_runs(sorter, &merger, first, merger.fan_in, append_sort_run_row, sorter);
+        sorter_add_run(sorter, start);
+        first += merger.fan_in;
+    }
+    merge_runs(sorter, &merger, first, sorter->num_runs - first, visit, arg);
+}
+
+/*Hands the sorted rows to visit*/
+void sorter_finish(Sorter* sorter, RowVisitor visit, void* arg){
+    if(sorter->num_runs == 0){
+        heap_sort_rows(sorter->rows, sorter->num_rows, sorter->column);
+        for(uint32_t i = 0; i < sorter->num_rows; i++){
+            if(!visit(&sorter->rows[i], arg)){
+                return;
+            }
+        }
+        return;
+    }
+    if(sorter->num_rows > 0){
+        sorter_spill(sorter);
+    }
+    sorter_merge(sorter, visit, arg);
+}
+
+void sorter_free(Sorter* sorter){
+    free(sorter->runs);
+    if(sorter->runs_file){
+        fclose(sorter->runs_file);
+    }
+}
+
+ExecuteResult execute_sorted_select(Statement* statement, Table* table){
+    if(statement->has_limit && statement->limit == 0){
+        return EXECUTE_SUCCESS;
+    }
+    uint32_t num_rows = count_subtree(table, table->root_page_num);
+    if(num_rows == 0){
+        return EXECUTE_SUCCESS;
+    }
+    Sorter sorter = {0};
+    sorter.column = statement->order_by;
+    sorter.arena = statement->arena;
+    sorter.capacity = table->sort_budget;
+    //only LIMIT+OFFSET rows can ever be printed, keep just those if they fit
+    uint64_t needed = (uint64_t)statement->limit + statement->offset;
+    if(statement->has_limit && needed <= table->sort_budget){
+        sorter.top_k = true;
+        sorter.capacity = needed;
+    }
+    if(sorter.capacity > num_rows){
+        //a small table fits in fewer rows than the budget
+        sorter.capacity = num_rows;
+    }
+    sorter.rows = arena_alloc(sorter.arena, sorter.capacity*sizeof(Row));
+
+    walk_subtree(table, table->root_page_num, sorter_add, &sorter);
+
+    RowLimiter limiter = {statement->offset, statement->limit, statement->has_limit,
+                            statement->emit_row, statement->emit_arg};
+    sorter_finish(&sorter, emit_limited_row, &limiter);
+    sorter_free(&sorter);
+    return EXECUTE_SUCCESS;
+}
+
+ExecuteResult execute_insert(Statement* statement,Table* table){
+    // if(table->num_rows >= TABLE_MAX_ROWS){
+    //     return EXECUTE_TABLE_FULL;
+    // }
+    Row* row_to_insert = &(statement->row_to_insert);
+    // Cursor* cursor = table_end(table);
+    uint32_t key_to_insert = row_to_insert->id;
+    Cursor cursor;
+    table_find(table,key_to_insert,&cursor);
+    //the leaf the key belongs in, not necessarily the root
+    void* node = get_page(table->pager,cursor.page_num);
+    uint32_t num_cells = *(leaf_node_num_cells(node));
+
+    //check if key already exists
+    if(cursor.cell_num < num_cells){
+        uint32_t key_at_index = *leaf_node_key(node,cursor.cell_num);
+        if(key_at_index == key_to_insert){
+            return EXECUTE_DUPLICATE_KEY;
+        }
+    }
+    // serialize_row(row_to_insert, cursor_value(cursor));
+    // table->num_rows += 1;
+    leaf_node_insert(&cursor,row_to_insert->id,row_to_insert);
+
+    return EXECUTE_SUCCESS;
+}
+
+/*select where id = n: at most one row, found without a scan*/
+ExecuteResult execute_point_select(Statement* statement, Table* table){
+    Cursor cursor;
+    if(!table_lookup(table, statement->where_id, &cursor)){
+        return EXECUTE_SUCCESS;
+    }
+    Row row;
+    deserialize_row(cursor_value(&cursor), &row);
+    RowLimiter limiter = {statement->offset, statement->limit, statement->has_limit,
+                            statement->emit_row, statement->emit_arg};
+    if(!statement->has_limit || statement->limit > 0){
+        emit_limited_row(&row, &limiter);
+    }
+    return EXECUTE_SUCCESS;
+}
+
+ExecuteResult execute_select(Statement* statement, Table* table){
+    if(statement->has_where_id){
+        return execute_point_select(statement, table);
+    }
+    if(statement->order_by != COLUMN_ID){
+        return execute_sorted_select(statement, table);
+    }
+    //rows come out of the tree in id order, stop as soon as the limit is hit
+    RowLimiter limiter = {statement->offset, statement->limit, statement->has_limit,
+                            statement->emit_row, statement->emit_arg};
+    if(!statement->has_limit || statement->limit > 0){
+        walk_subtree(table, table->root_page_num, emit_limited_row, &limiter);
+    }
+    return EXECUTE_SUCCESS;
+}
+
+
+/*MIN/MAX of a text column, folded over the rows as they are walked*/
+typedef struct{
+    Column column;
+    bool is_max;
+    Value* result; //VALUE_NULL until the first row
+}TextExtreme;
+
+bool fold_text_extreme(Row* row, void* arg){
+    TextExtreme* fold = arg;
+    char* value = row_column_text(row, fold->column);
+    Value* result = fold->result;
+    int cmp = result->type == VALUE_TEXT ? strcmp(value, result->text) : 0;
+    if(result->type != VALUE_TEXT || (fold->is_max ? cmp > 0 : cmp < 0)){
+        result->type = VALUE_TEXT;
+        strcpy(result->text, value);
+    }
+    return true;
+}
+
+/*Leaves the result in statement->aggregate_result*/
+ExecuteResult execute_aggregate(Statement* statement, Table* table){
+    Column column = statement->aggregate_column;
+    Value* result = &statement->aggregate_result;
+    result->type = VALUE_INTEGER;
+
+    switch(statement->aggregate){
+        case(AGGREGATE_COUNT):
+            result->integer = count_subtree(table, table->root_page_num);
+            return EXECUTE_SUCCESS;
+        case(AGGREGATE_SUM):
+            result->integer = sum_subtree_keys(table, table->root_page_num);
+            return EXECUTE_SUCCESS;
+        case(AGGREGATE_AVG): {
+            uint32_t count = count_subtree(table, table->root_page_num);
+            if(count == 0){
+                result->type = VALUE_NULL;
+                return EXECUTE_SUCCESS;
+            }
+            uint64_t sum = sum_subtree_keys(table, table->root_page_num);
+            result->type = VALUE_REAL;
+            result->real = (double)sum/count;
+            return EXECUTE_SUCCESS;
+        }
+        default:
+            break;
+    }
+
+    bool is_max = statement->aggregate == AGGREGATE_MAX;
+    //only an empty root leaf has no cells, so either edge leaf tells if there are rows
+    void* leaf = table_edge_leaf(table, is_max);
+    uint32_t num_cells = *leaf_node_num_cells(leaf);
+    if(num_cells == 0){
+        //MIN and MAX of no rows
+        result->type = VALUE_NULL;
+        return EXECUTE_SUCCESS;
+    }
+    if(column == COLUMN_ID){
+        //keys are sorted, so the answer is at one edge of the tree
+        result->integer = *leaf_node_key(leaf, is_max ? num_cells-1 : 0);
+        return EXECUTE_SUCCESS;
+    }
+
+    //text columns aren't indexed, fold over every row
+    result->type = VALUE_NULL;
+    TextExtreme fold = {column, is_max, result};
+    walk_subtree(table, table->root_page_num, fold_text_extreme, &fold);
+    return EXECUTE_SUCCESS;
+}
+
+PrepareResult prepare_insert(char* sql, Statement* statement){
+    statement->type = STATEMENT_INSERT;
+    char* keyword = strtok(sql, " ");
+    char* id_string = strtok(NULL, " ");
+    char* username = strtok(NULL, " ");
+    char* email = strtok(NULL, " ");
+
+    if(id_string==NULL || username==NULL || email==NULL){
+        return PREPARE_SYNTAX_ERROR;
+    }
+    int id = atoi(id_string);
+    //how to make sure id_string is a number?
+    if(id<0){
+        return PREPARE_NEGATIVE_ID;
+    }
+    if(strlen(username)>COLUMN_USERNAME_SIZE) return PREPARE_STRING_TOO_LONG;
+    if(strlen(email)>COLUMN_EMAIL_SIZE) return PREPARE_STRING_TOO_LONG;
+    
+    statement->row_to_insert.id = id;
+    strcpy(statement->row_to_insert.username,username);
+    strcpy(statement->row_to_insert.email,email);
+    return PREPARE_SUCCESS;
+}
+
+bool parse_column(char* name, Column* column){
+    if(!strcmp(name,"id")) *column = COLUMN_ID;
+    else if(!strcmp(name,"username")) *column = COLUMN_USERNAME;
+    else if(!strcmp(name,"email")) *column = COLUMN_EMAIL;
+    else return false;
+    return true;
+}
+
+//false unless string is all digits and fits in 32 bits
+bool parse_count(char* string, uint32_t* count){
+    if(string == NULL || string[0] == 0 || strspn(string,"0123456789") != strlen(string)){
+        return false;
+    }
+    errno = 0;
+    unsigned long value = strtoul(string, NULL, 10);
+    if(errno == ERANGE || value > UINT32_MAX){
+        return false;
+    }
+    *count = value;
+    return true;
+}
+
+/*count(*) | count(<column>) | min(<column>) | max(<column>) | sum(id) | avg(id)*/
+PrepareResult prepare_aggregate(char* expression, Statement* statement){
+    char* open_paren = strchr(expression, '(');
+    size_t length = strlen(expression);
+    if(open_paren == NULL || expression[length-1] != ')'){
+        return PREPARE_SYNTAX_ERROR;
+    }
+    *open_paren = 0;
+    expression[length-1] = 0;
+    char* function = expression;
+    char* column = open_paren+1;
+
+    if(!strcmp(function,"count")) statement->aggregate = AGGREGATE_COUNT;
+    else if(!strcmp(function,"min")) statement->aggregate = AGGREGATE_MIN;
+    else if(!strcmp(function,"max")) statement->aggregate = AGGREGATE_MAX;
+    else if(!strcmp(function,"sum")) statement->aggregate = AGGREGATE_SUM;
+    else if(!strcmp(function,"avg")) statement->aggregate = AGGREGATE_AVG;
+    else return PREPARE_SYNTAX_ERROR;
+
+    if(!strcmp(column,"*")) statement->aggregate_column = COLUMN_ALL;
+    else if(!parse_column(column, &statement->aggregate_column)) return PREPARE_SYNTAX_ERROR;
+
+    //only count takes *, and only id is a number
+    if(statement->aggregate_column == COLUMN_ALL &&
+        statement->aggregate != AGGREGATE_COUNT){
+        return PREPARE_SYNTAX_ERROR;
+    }
+    if((statement->aggregate == AGGREGATE_SUM || statement->aggregate == AGGREGATE_AVG) &&
+        statement->aggregate_column != COLUMN_ID){
+        return PREPARE_SYNTAX_ERROR;
+    }
+    return PREPARE_SUCCESS;
+}
+
+/*select [order by <column>] [limit <n>] [offset <n>]
+select <aggregate>*/
+PrepareResult prepare_select(char* sql, Statement* statement){
+    statement->type = STATEMENT_SELECT;
+    statement->aggregate = AGGREGATE_NONE;
+    statement->order_by = COLUMN_ID;
+    statement->has_limit = false;
+    statement->limit = 0;
+    statement->offset = 0;
+    statement->has_where_id = false;
+    char* keyword = strtok(sql, " ");
+    if(strcmp(keyword, "select")){
+        return PREPARE_UNRECOGNIZED_STATEMENT;
+    }
+
+    char* token = strtok(NULL, " ");
+    if(token != NULL && strchr(token, '(') != NULL){
+        if(strtok(NULL, " ") != NULL){
+            return PREPARE_SYNTAX_ERROR;
+        }
+        return prepare_aggregate(token, statement);
+    }
+
+    //each clause can only be given once
+    bool has_order_by = false;
+    bool has_offset = false;
+    while(token != NULL){
+        if(!strcmp(token,"order")){
+            char* by = strtok(NULL, " ");
+            char* column = strtok(NULL, " ");
+            if(has_order_by || by == NULL || strcmp(by,"by") || column == NULL ||
+                !parse_column(column, &statement->order_by)){
+                return PREPARE_SYNTAX_ERROR;
+            }
+            has_order_by = true;
+        }else if(!strcmp(token,"limit")){
+            if(statement->has_limit || !parse_count(strtok(NULL, " "), &statement->limit)){
+                return PREPARE_SYNTAX_ERROR;
+            }
+            statement->has_limit = true;
+        }else if(!strcmp(token,"offset")){
+            if(has_offset || !parse_count(strtok(NULL, " "), &statement->offset)){
+                return PREPARE_SYNTAX_ERROR;
+            }
+            has_offset = true;
+        }else if(!strcmp(token,"where")){
+            if(statement->has_where_id){
+                return PREPARE_SYNTAX_ERROR;
+            }
+            //only exact matches on id: where id = <n>
+            char* column = strtok(NULL, " ");
+            char* equals = strtok(NULL, " ");
+            if(column == NULL || strcmp(column,"id") || equals == NULL || strcmp(equals,"=") ||
+                !parse_count(strtok(NULL, " "), &statement->where_id)){
+                return PREPARE_SYNTAX_ERROR;
+            }
+            statement->has_where_id = true;
+        }else{
+            return PREPARE_SYNTAX_ERROR;
+        }
+        token = strtok(NULL, " ");
+    }
+    return PREPARE_SUCCESS;
+}
+
+//Our "SQL compiler". Now our compiler only understands two words
+PrepareResult prepare_statement(char* sql,Statement* statement){
+    if (!strncmp(sql,"insert",6)){
+        return prepare_insert(sql, statement);
+
+        //scanf when inputting more than it should buffer overflows so we'll first 
+        //break down the string into the three keywords and then check their length
+        //using strtok
+        // statement->type = STATEMENT_INSERT;
+        // int args_assigned = sscanf(
+        //     sql,"insert %d %s %s",&(statement->row_to_insert.id),
+        //      statement->row_to_insert.username, statement->row_to_insert.email
+        // );
+        // if(args_assigned<3){
+        //     return PREPARE_SYNTAX_ERROR;
+        // }
+        // return PREPARE_SUCCESS;
+    }
+    if (!strncmp(sql,"select",6)){
+        return prepare_select(sql, statement);
+    }
+    return PREPARE_UNRECOGNIZED_STATEMENT;
+}
+
+ExecuteResult execute_statement(Statement* statement,Table* table){
+    TRACE_BEGIN(trace_start_ns);
+    uint64_t start = now_ns();
+    Arena scratch = {0};
+    bool own_arena = statement->arena == NULL;
+    if(own_arena){
+        statement->arena = &scratch;
+    }
+    ExecuteResult result;
+    if(statement->type == STATEMENT_INSERT){
+        result = execute_insert(statement,table);
+    }else if(statement->aggregate != AGGREGATE_NONE){
+        result = execute_aggregate(statement,table);
+    }else{
+        result = execute_select(statement,table);
+    }
+    if(own_arena){
+        arena_free(&scratch);
+        statement->arena = NULL;
+    }
+    latency_record(&table->latency[statement->type], now_ns()-start);
+    TRACE_END(trace_start_ns, TRACE_STATEMENT, statement->type);
+    return result;
+}
+
+/*Embeddable API*/
+/* A prepared statement runs on its first db_step(); the rows of a select
+are collected then and handed out one per db_step() call.*/
+struct PreparedStatement{
+    Table* table;
+    Statement statement;
+    Arena arena; //the sql copy, collected rows and execution scratch
+    bool executed;
+    ExecuteResult execute_result;
+    RowBuffer rows;
+    uint32_t next_row;
+    bool value_returned;
+    uint64_t output_start_ns; //for TRACE_OUTPUT, 0 when not tracing
+    bool allocated; //by db_prepare(), so db_finalize() frees it
+    max_align_t first_block[ARENA_FIRST_BLOCK_SIZE/sizeof(max_align_t)]; //stays last, isn't zeroed
+};
+_Static_assert(sizeof(PreparedStatement) <= sizeof(PreparedStatementStorage),
+                "DB_STATEMENT_STORAGE_SIZE is too small");
+
+/*The arena can't grow a block in place, so a full buffer is copied
+into one twice its size; the old one is dropped with the arena.*/
+bool collect_row(Row* row, void* arg){
+    PreparedStatement* prepared = arg;
+    RowBuffer* buffer = &prepared->rows;
+    if(buffer->num_rows == buffer->capacity){
+        buffer->capacity = buffer->capacity ? buffer->capacity*2 : LEAF_NODE_MAX_CELLS;
+        Row* rows = arena_alloc(&prepared->arena, buffer->capacity*sizeof(Row));
+        if(buffer->num_rows > 0){
+            memcpy(rows, buffer->rows, buffer->num_rows*sizeof(Row));
+        }
+        buffer->rows = rows;
+    }
+    buffer->rows[buffer->num_rows] = *row;
+    buffer->num_rows += 1;
+    return true;
+}
+
+PrepareResult prepare_in_place(Table* table, const char* sql, PreparedStatement* prepared){
+    memset(prepared, 0, offsetof(PreparedStatement, first_block));
+    prepared->table = table;
+    arena_init(&prepared->arena, prepared->first_block, sizeof(prepared->first_block));
+    //prepare_statement tokenizes in place
+    size_t length = strlen(sql)+1;
+    char* buffer = arena_alloc(&prepared->arena, length);
+    memcpy(buffer, sql, length);
+    PrepareResult result = prepare_statement(buffer, &prepared->statement);
+    if(result != PREPARE_SUCCESS){
+        arena_free(&prepared->arena);
+        return result;
+    }
+    prepared->statement.emit_row = collect_row;
+    prepared->statement.emit_arg = prepared;
+    prepared->statement.arena = &prepared->arena;
+    return PREPARE_SUCCESS;
+}
+
+/*statement is set to NULL unless PREPARE_SUCCESS is returned*/
+PrepareResult db_prepare(Table* table, const char* sql, PreparedStatement** statement){
+    PreparedStatement* prepared = malloc(sizeof(PreparedStatement));
+    PrepareResult result = prepare_in_place(table, sql, prepared);
+    if(result != PREPARE_SUCCESS){
+        free(prepared);
+        *statement = NULL;
+        return result;
+    }
+    prepared->allocated = true;
+    *statement = prepared;
+    return PREPARE_SUCCESS;
+}
+
+/*Like db_prepare(), with the statement living in storage until db_finalize()*/
+PrepareResult db_prepare_into(Table* table, const char* sql, PreparedStatementStorage* storage,
+                                PreparedStatement** statement){
+    PreparedStatement* prepared = (PreparedStatement*)storage;
+    PrepareResult result = prepare_in_place(table, sql, prepared);
+    *statement = result == PREPARE_SUCCESS ? prepared : NULL;
+    return result;
+}
+
+/*Runs the statement without handing out any rows yet,
+db_step() calls it if it hasn't run*/
+ExecuteResult db_execute(PreparedStatement* statement){
+    if(!statement->executed){
+        statement->executed = true;
+        statement->execute_result = execute_statement(&statement->statement, statement->table);
+        //the rest, until db_finalize(), is the client reading the results
+        statement->output_start_ns = trace_enabled() ? now_ns() : 0;
+    }
+    return statement->execute_result;
+}
+
+StepResult db_step(PreparedStatement* statement){
+    if(db_execute(statement) != EXECUTE_SUCCESS){
+        return STEP_ERROR;
+    }
+    if(statement->next_row < statement->rows.num_rows){
+        statement->next_row += 1;
+        return STEP_ROW;
+    }
+    if(statement->statement.type == STATEMENT_SELECT &&
+        statement->statement.aggregate != AGGREGATE_NONE && !statement->value_returned){
+        statement->value_returned = true;
+        return STEP_VALUE;
+    }
+    return STEP_DONE;
+}
+
+//valid until the next db_step()
+Row* db_row(PreparedStatement* statement){
+    if(statement->next_row == 0){
+        return NULL;
+    }
+    return &statement->rows.rows[statement->next_row-1];
+}
+
+Value* db_value(PreparedStatement* statement){
+    return &statement->statement.aggregate_result;
+}
+
+ExecuteResult db_execute_result(PreparedStatement* statement){
+    return statement->execute_result;
+}
+
+void db_finalize(PreparedStatement* statement){
+    TRACE_END(statement->output_start_ns, TRACE_OUTPUT, 0);
+    arena_free(&statement->arena);
+    if(statement->allocated){
+        free(statement);
+    }
+}
+
+/*Memory*/
+struct ArenaBlock{
+    ArenaBlock* next;
+    size_t size;
+    size_t used;
+    max_align_t data[]; //keeps every allocation suitably aligned
+};
+
+void arena_init(Arena* arena, void* first_block, size_t size){
+    arena->blocks = NULL;
+    arena->first = first_block;
+    arena->first_size = size;
+    arena->first_used = 0;
+}
+
+void* arena_alloc(Arena* arena, size_t size){
+    //round up so the next allocation stays aligned
+    size = (size + sizeof(max_align_t)-1) / sizeof(max_align_t) * sizeof(max_align_t);
+    if(arena->first != NULL && arena->first_size - arena->first_used >= size){
+        void* memory = arena->first + arena->first_used;
+        arena->first_used += size;
+        return memory;
+    }
+    ArenaBlock* block = arena->blocks;
+    if(block == NULL || block->size - block->used < size){
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        if(block == NULL){
+            printf("Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+        block->size = block_size;
+        block->used = 0;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+    void* memory = (uint8_t*)block->data + block->used;
+    block->used += size;
+    return memory;
+}
+
+void arena_free(Arena* arena){
+    ArenaBlock* block = arena->blocks;
+    while(block != NULL){
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->first_used = 0;
+}
+
+void* frame_alloc(FrameAllocator* frames){
+    if(frames->free_frames == NULL){
+        if(frames->num_slabs == PAGE_SLABS){
+            printf("Out of page frames.\n");
+            exit(EXIT_FAILURE);
+        }
+        void* slab;
+        if(posix_memalign(&slab, PAGE_SIZE, PAGE_FRAMES_PER_SLAB*PAGE_SIZE) != 0){
+            printf("Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+        frames->slabs[frames->num_slabs++] = slab;
+        for(uint32_t i = PAGE_FRAMES_PER_SLAB; i > 0; i--){
+            frame_free(frames, (uint8_t*)slab + (i-1)*PAGE_SIZE);
+        }
+    }
+    void* frame = frames->free_frames;
+    frames->free_frames = *(void**)frame;
+    return frame;
+}
+
+void frame_free(FrameAllocator* frames, void* frame){
+    *(void**)frame = frames->free_frames;
+    frames->free_frames = frame;
+}
+
+void frame_allocator_free(FrameAllocator* frames){
+    for(uint32_t i = 0; i < frames->num_slabs; i++){
+        free(frames->slabs[i]);
+    }
+    frames->num_slabs = 0;
+    frames->free_frames = NULL;
+}
+/*O_DIRECT offsets and lengths have to be multiples of this,
+a whole page is always safe*/
+uint32_t direct_io_alignment(int fd){
+#ifdef STATX_DIOALIGN
+    struct statx file_stat;
+    if(statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &file_stat) == 0 &&
+        (file_stat.stx_mask & STATX_DIOALIGN) && file_stat.stx_dio_offset_align > 0 &&
+        file_stat.stx_dio_offset_align <= PAGE_SIZE){
+        return file_stat.stx_dio_offset_align;
+    }
+#endif
+    return PAGE_SIZE;
+}
+
+/*With direct_io every read and write goes straight between the page frames
+and the disk: frames are PAGE_SIZE aligned (see frame_alloc()), offsets are
+page multiples and every transfer is a whole page.*/
+Pager* pager_open(const char* filename, bool direct_io){
+    int fd = open(filename, 
+                O_RDWR| //Read/write mode
+                    O_CREAT| //create file if it does not exit
+                    (direct_io ? O_DIRECT : 0), //skip the kernel page cache
+                S_IWUSR | //user write permission
+                    S_IRUSR ); //user read permission
+    if(fd == -1){
+        if(direct_io && errno == EINVAL){
+            printf("Unable to open file: O_DIRECT isn't supported here\n");
+        }else{
+            printf("Unable to open file\n");
+        }
+        exit(EXIT_FAILURE);
+    }
+    //use off_t for file sizes
+    off_t file_length = lseek(fd,0,SEEK_END);
+
+    Pager* pager = malloc(sizeof(Pager));
+    pager->file_descriptor = fd;
+    pager->file_length = file_length;
+    pager->num_pages = (file_length/PAGE_SIZE);
+    
+    if(file_length % PAGE_SIZE !=0){
+        printf("%ld %d %ld %ld\n", file_length,PAGE_SIZE,file_length/PAGE_SIZE,file_length%PAGE_SIZE);
+        printf("Db file is not a whole no. of pages. Corrupt file.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(uint32_t i = 0;i< TABLE_MAX_PAGES; i++){
+        pager->pages[i] = NULL;
+    }
+    pager->compress_pages = false;
+    pager->direct_io = direct_io;
+    pager->io_unit = direct_io ? direct_io_alignment(fd) : 1; //buffered I/O takes any length
+    pager->write_buffer = NULL;
+    if(direct_io && posix_memalign(&pager->write_buffer, PAGE_SIZE, PAGE_SIZE) != 0){
+        printf("Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(&pager->frames, 0, sizeof(FrameAllocator));
+    memset(&pager->stats, 0, sizeof(PagerStats));
+    pager->lsn = 0;
+    memset(pager->page_lsn, 0, sizeof(pager->page_lsn));
+    pthread_mutex_init(&pager->lock, NULL);
+    return pager;
+}
+// Table* new_table(){
+Table* db_open(const char* filename){
+    return db_open_flags(filename, 0);
+}
+
+Table* db_open_flags(const char* filename, uint32_t flags){
+    Pager* pager = pager_open(filename, flags & DB_OPEN_DIRECT_IO);
+    // uint32_t num_rows = pager->file_length / ROW_SIZE;
+    Table* table = calloc(1, sizeof(Table));
+    // table->num_rows = num_rows; //if new file table->num_rows = 0
+    table->pager = pager;
+    table->root_page_num = 0;
+    table->sort_budget = DEFAULT_SORT_BUDGET;
+
+    if(pager->num_pages==0){
+        //New file, intiliaze page 0 as leaf node
+        void* root_node = get_page(pager,0);
+        initialize_leaf_node(root_node);
+        set_node_root(root_node, true);
+        pager_mark_dirty(pager, 0);
+    } 
+
+    table->hash_index_path = malloc(strlen(filename)+sizeof("-hash"));
+    sprintf(table->hash_index_path, "%s-hash", filename);
+    open_hash_index(table);
+    return table;
+}
+
+void pager_io_error(const char* what){
+    printf("Error %s: %d\n", what, errno);
+    exit(EXIT_FAILURE);
+}
+
+/*Reads the whole slot in one go, a compressed page is expanded by the
+caller. The hole punched after a compressed page reads back as zeros
+without touching the disk. Returns the no. of bytes read.*/
+ssize_t read_page(Pager* pager, uint32_t page_num, void* page){
+    ssize_t bytes_read = pread(pager->file_descriptor, page, PAGE_SIZE, (off_t)page_num*PAGE_SIZE);
+    if(bytes_read == -1){
+        pager_io_error("reading file");
+    }
+    return bytes_read;
+}
+
+/*Reads page_num into page, a compressed page is expanded so the cache
+only holds raw pages. Returns the no. of bytes read, 0 for a page past
+the end of the file. Called under pager->lock.*/
+ssize_t load_page(Pager* pager, uint32_t page_num, void* page){
+    uint32_t num_pages = pager->file_length/PAGE_SIZE;
+    if(pager->file_length%PAGE_SIZE!=0){
+        num_pages += 1;
+    }
+    // if the requested page_num is within the bounds of the file.
+    if(page_num > num_pages){
+        return 0;
+    }
+    TRACE_BEGIN(trace_start_ns);
+    ssize_t bytes_read = read_page(pager, page_num, page);
+    if(bytes_read > 0 && *((uint8_t*)page) == COMPRESSED_PAGE_MARKER){
+        uint8_t compressed[PAGE_SIZE];
+        memcpy(compressed, page, bytes_read);
+        decompress_page(compressed, bytes_read, page);
+    }
+    TRACE_END(trace_start_ns, TRACE_PAGE_READ, page_num);
+    return bytes_read;
+}
+
+void* get_page(Pager* pager, uint32_t page_num){
+    if(page_num >= TABLE_MAX_PAGES){
+        printf("Tried to fetch page number out of bounds. %d >= %d \n",
+        page_num,TABLE_MAX_PAGES);
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_lock(&pager->lock);
+    if(pager->pages[page_num] != NULL){
+        pager->stats.cache_hits += 1;
+    }else{
+        //Cache miss, Allocate memory and load from file
+        pager->stats.cache_misses += 1;
+        void* page = frame_alloc(&pager->frames);
+        ssize_t bytes_read = load_page(pager, page_num, page);
+        if(bytes_read > 0){
+            pager->stats.pages_read += 1;
+            pager->stats.bytes_read += bytes_read;
+        }
+
+        pager->pages[page_num] = page;
+
+        if(page_num>=pager->num_pages){
+            pager->num_pages += 1;
+        }
+    }
+    void* page = pager->pages[page_num];
+    pthread_mutex_unlock(&pager->lock);
+    return page;
+
+}
+
+/*The cached page, or else a copy read into a frame of its own (*frame)
+that stays out of the cache and the counters. For looking at the tree
+without changing what later statements hit or miss.*/
+void* peek_page(Pager* pager, uint32_t page_num, void** frame){
+    pthread_mutex_lock(&pager->lock);
+    void* page = pager->pages[page_num];
+    *frame = NULL;
+    if(page == NULL){
+        *frame = frame_alloc(&pager->frames);
+        load_page(pager, page_num, *frame);
+        page = *frame;
+    }
+    pthread_mutex_unlock(&pager->lock);
+    return page;
+}
+
+void release_peeked_page(Pager* pager, void* frame){
+    if(frame == NULL){
+        return;
+    }
+    pthread_mutex_lock(&pager->lock);
+    frame_free(&pager->frames, frame);
+    pthread_mutex_unlock(&pager->lock);
+}
+
+//size is also needed cuz of the possibility of partial pages
+void pager_flush(Pager* pager, uint32_t page_num){
+    if(pager->pages[page_num]==NULL){
+        printf("Tried to flush null page\n");
+        exit(EXIT_FAILURE);
+    }
+    TRACE_BEGIN(trace_start_ns);
+    off_t offset = (off_t)page_num*PAGE_SIZE;
+
+    void* source = pager->pages[page_num];
+    uint32_t size = PAGE_SIZE;
+    uint8_t compressed[PAGE_SIZE];
+    //a page rounded up to io_unit can't get any shorter when io_unit is a page
+    if(pager->compress_pages && pager->io_unit < PAGE_SIZE){
+        uint32_t compressed_size = compress_page(source, compressed);
+        //incompressible pages are written raw
+        if(compressed_size > 0){
+            source = compressed;
+            size = compressed_size;
+        }
+    }
+    if(pager->direct_io && size < PAGE_SIZE){
+        //O_DIRECT moves whole aligned blocks, pad the compressed page to one
+        uint32_t padded_size = (size + pager->io_unit-1) / pager->io_unit * pager->io_unit;
+        memcpy(pager->write_buffer, source, size);
+        memset((uint8_t*)pager->write_buffer+size, 0, padded_size-size);
+        source = pager->write_buffer;
+        size = padded_size;
+    }
+
+    ssize_t bytes_written = 
+        pwrite(pager->file_descriptor, source, size, offset);
+    if(bytes_written == -1){
+        pager_io_error("writing");
+    }
+    /*give the rest of the slot back to the filesystem, it only frees
+    whole blocks and leaves the file length alone*/
+    if(size < PAGE_SIZE &&
+        fallocate(pager->file_descriptor, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                    offset+size, PAGE_SIZE-size) == -1 &&
+        errno != EOPNOTSUPP && errno != ENOSYS){
+        pager_io_error("punching hole");
+    }
+    pthread_mutex_lock(&pager->lock);
+    pager->stats.pages_written += 1;
+    pager->stats.bytes_written += bytes_written;
+    pthread_mutex_unlock(&pager->lock);
+    TRACE_END(trace_start_ns, TRACE_PAGE_WRITE, page_num);
+    // printf("saved\n");
+}
+
+
+/*Every change to a cached page has to be followed by this,
+it's how a backup knows what changed under it*/
+void pager_mark_dirty(Pager* pager, uint32_t page_num){
+    pager->lsn += 1;
+    pager->page_lsn[page_num] = pager->lsn;
+}
+
+/*Online backup*/
+/* A backup copies a few pages per db_backup_step(), statements can run
+in between. Each copied page remembers the LSN it was copied at, and a
+page whose LSN moved on since is copied again, so when a step finds
+every page current the copy is a consistent snapshot of that moment.
+An incremental backup starts out treating every page as copied at the
+last finished backup's LSN: only pages changed since then are written
+into dest. That only works if dest is the file the last backup wrote and
+is still at least that long, otherwise a full copy is taken.*/
+struct Backup{
+    Table* table;
+    char* dest_path;
+    int fd;
+    bool copied[TABLE_MAX_PAGES];
+    uint64_t copied_lsn[TABLE_MAX_PAGES];
+    uint32_t pages_copied;
+};
+
+Backup* db_backup_start(Table* table, const char* dest_path, bool incremental){
+    //without an earlier backup (in this process) of dest there is nothing to be incremental to
+    struct stat dest_stat;
+    incremental = incremental && table->backup_path != NULL &&
+                    !strcmp(dest_path, table->backup_path) &&
+                    stat(dest_path, &dest_stat) == 0 &&
+                    dest_stat.st_size >= (off_t)table->backup_pages*PAGE_SIZE;
+    int fd = open(dest_path, O_WRONLY | O_CREAT | (incremental ? 0 : O_TRUNC),
+                    S_IWUSR | S_IRUSR);
+    if(fd == -1){
+        return NULL;
+    }
+    Backup* backup = calloc(1, sizeof(Backup));
+    backup->table = table;
+    backup->dest_path = strdup(dest_path);
+    backup->fd = fd;
+    if(incremental){
+        for(uint32_t i = 0; i < TABLE_MAX_PAGES; i++){
+            backup->copied[i] = true;
+            backup->copied_lsn[i] = table->backup_lsn;
+        }
+    }
+    return backup;
+}
+
+/*Copies up to max_pages pages that are missing or stale in the copy*/
+BackupResult db_backup_step(Backup* backup, uint32_t max_pages){
+    Pager* pager = backup->table->pager;
+    uint32_t copied = 0;
+    for(uint32_t i = 0; i < pager->num_pages && copied < max_pages; i++){
+        if(backup->copied[i] && pager->page_lsn[i] <= backup->copied_lsn[i]){
+            continue;
+        }
+        void* page = get_page(pager, i);
+        if(pwrite(backup->fd, page, PAGE_SIZE, (off_t)i*PAGE_SIZE) != PAGE_SIZE){
+            return BACKUP_ERROR;
+        }
+        backup->copied[i] = true;
+        backup->copied_lsn[i] = pager->page_lsn[i];
+        backup->pages_copied += 1;
+        copied += 1;
+    }
+    if(copied == max_pages){
+        return BACKUP_OK;
+    }
+
+    //nothing left that's stale
+    if(ftruncate(backup->fd, (off_t)pager->num_pages*PAGE_SIZE) == -1 ||
+        fsync(backup->fd) == -1){
+        return BACKUP_ERROR;
+    }
+    Table* table = backup->table;
+    free(table->backup_path);
+    table->backup_path = strdup(backup->dest_path);
+    table->backup_pages = pager->num_pages;
+    table->backup_lsn = pager->lsn;
+    return BACKUP_DONE;
+}
+
+uint32_t db_backup_pages_copied(Backup* backup){
+    return backup->pages_copied;
+}
+
+/*Closes dest, an unfinished backup is left as is*/
+void db_backup_finish(Backup* backup){
+    close(backup->fd);
+    free(backup->dest_path);
+    free(backup);
+}
+
+/*Flushes every cached page and frees the pager*/
+void pager_close(Pager* pager){
+    // uint32_t num_full_pages = table->num_rows/ROWS_PER_PAGE;
+
+    for(uint32_t i = 0; i<pager->num_pages; i++){
+        if(pager->pages[i] == NULL){
+            continue;
+        }
+        pager_flush(pager, i);
+        frame_free(&pager->frames, pager->pages[i]);
+        pager->pages[i] = NULL;
+    }
+
+    //Free partial page
+    // uint32_t num_additional_rows = table->num_rows % ROWS_PER_PAGE;
+    // if(num_additional_rows > 0){
+    //     //partial page exists
+    //     uint32_t page_num = num_full_pages;
+    //     if(pager->pages[page_num]!=NULL){
+    //         pager_flush(pager,page_num,num_additional_rows*ROW_SIZE);
+    //         free(pager->pages[page_num]);
+    //         pager->pages[page_num] = NULL;
+    //     }
+    // }
+
+    /*compressed pages don't fill their slot, keep the file a whole no. of pages*/
+    if(ftruncate(pager->file_descriptor, (off_t)pager->num_pages*PAGE_SIZE) == -1){
+        printf("Error truncating db file: %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+
+    int result = close(pager->file_descriptor);
+    if(result == -1){
+        printf("Error closing db file.\n");
+        exit(EXIT_FAILURE);
+    }
+    //Making sure all pages are freed from memory?
+    for(uint32_t i =0; i<TABLE_MAX_PAGES; i++){
+        void* page = pager->pages[i];
+        if(page){
+            frame_free(&pager->frames, page);
+            pager->pages[i] = NULL;
+        }
+    }
+    frame_allocator_free(&pager->frames);
+    free(pager->write_buffer);
+    pthread_mutex_destroy(&pager->lock);
+    free(pager);
+}
+
+//flushes the page cache to disk, closes the db file, frees Pager and Table data structures
+void db_close(Table* table){
+    //the inode outlives the descriptor, pager_close() truncates the file to its pages
+    struct stat db_stat;
+    if(fstat(table->pager->file_descriptor, &db_stat) == -1){
+        pager_io_error("reading db file size");
+    }
+    uint64_t db_size = (uint64_t)table->pager->num_pages*PAGE_SIZE;
+    pager_close(table->pager);
+    if(table->hash_index != NULL){
+        close_hash_index(table, &db_stat, db_size);
+    }
+    free(table->hash_index_path);
+    free(table->backup_path);
+    free(table);
+}
@@ -0,0 +1,182 @@
+#ifndef DB_H
+#define DB_H
+
+/*The database engine: pager, B-tree, "SQL compiler" and executor.
+main.c (the REPL) is just one client of it. This is the embeddable API,
+the engine's internals are in db_internal.h.
+
+Embedding:
+    Table* table = db_open("my.db");
+    PreparedStatement* statement;
+    if(db_prepare(table, "select order by username limit 10", &statement) == PREPARE_SUCCESS){
+        while(db_step(statement) == STEP_ROW){
+            Row* row = db_row(statement);
+            ...
+        }
+        db_finalize(statement);
+    }
+    db_close(table);
+
+Building the library:
+    gcc -O2 -c db.c -o db.o && ar rcs libdb.a db.o     (static)
+    gcc -O2 -shared -fPIC db.c -o libdb.so             (shared)
+*/
+
+#include<stdbool.h>
+#include<stddef.h>
+#include<stdint.h>
+
+/*instead of using exceptions (C doesn't support exception handling)
+like how we would use in say Python,
+we simply use enum result codes
+*/
+typedef enum{
+    PREPARE_SUCCESS,
+    PREPARE_UNRECOGNIZED_STATEMENT,
+    PREPARE_SYNTAX_ERROR,
+    PREPARE_STRING_TOO_LONG,
+    PREPARE_NEGATIVE_ID
+} PrepareResult;
+
+//just two values for now
+typedef enum{
+    STATEMENT_INSERT,
+    STATEMENT_SELECT
+} StatementType;
+#define STATEMENT_TYPE_COUNT 2
+
+typedef enum{
+    EXECUTE_SUCCESS,
+    EXECUTE_TABLE_FULL,
+    EXECUTE_DUPLICATE_KEY
+}ExecuteResult;
+
+//what db_step() produced
+typedef enum{
+    STEP_ROW, //db_row() is the next row
+    STEP_VALUE, //db_value() is the aggregate's result
+    STEP_DONE,
+    STEP_ERROR //see db_execute_result()
+}StepResult;
+
+
+#define COLUMN_USERNAME_SIZE 32
+#define COLUMN_EMAIL_SIZE 255
+typedef struct {
+    uint32_t id;
+    char username[COLUMN_USERNAME_SIZE+1];
+    char email[COLUMN_EMAIL_SIZE+1];
+} Row;
+
+//result of an aggregate
+typedef enum{
+    VALUE_NULL, //MIN, MAX or AVG of no rows
+    VALUE_INTEGER,
+    VALUE_REAL,
+    VALUE_TEXT
+}ValueType;
+
+typedef struct{
+    ValueType type;
+    uint64_t integer;
+    double real;
+    char text[COLUMN_EMAIL_SIZE+1];
+}Value;
+
+/*Performance statistics*/
+/* Counters are always on, they are plain increments on paths that
+already do far more work. Exposed through .stats and db_get_stats().*/
+typedef struct{
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t pages_read;
+    uint64_t pages_written;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+}PagerStats;
+
+//latencies of one statement type, in ns
+typedef struct{
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+}LatencyStats;
+
+#define STATS_MAX_LEVELS 16
+typedef struct{
+    PagerStats pager;
+    uint64_t leaf_splits;
+    uint64_t root_splits;
+    uint32_t tree_height;
+    uint32_t nodes_per_level[STATS_MAX_LEVELS]; //level 0 = root
+    double fill_factor[STATS_MAX_LEVELS]; //used cells / cell capacity
+    LatencyStats latency[STATEMENT_TYPE_COUNT]; //per StatementType
+}DbStats;
+
+/*Embeddable API*/
+typedef struct Table Table;
+typedef struct PreparedStatement PreparedStatement;
+typedef struct Backup Backup;
+
+//memory a caller can prepare a statement into instead of db_prepare() allocating it
+#define DB_STATEMENT_STORAGE_SIZE 8192
+typedef union{
+    max_align_t align;
+    uint8_t bytes[DB_STATEMENT_STORAGE_SIZE];
+}PreparedStatementStorage;
+
+typedef enum{
+    BACKUP_OK, //more pages to copy
+    BACKUP_DONE, //the copy matches the database
+    BACKUP_ERROR
+}BackupResult;
+
+//db_open_flags() flags
+#define DB_OPEN_DIRECT_IO 0x1 //bypass the kernel page cache (O_DIRECT)
+
+//db_set_option() options
+typedef enum{
+    DB_OPTION_COMPRESS, //0 or 1: compress pages on writeback
+    DB_OPTION_SORT_BUDGET //rows an ORDER BY keeps in memory, at least 1
+}DbOption;
+
+Table* db_open(const char* filename);
+Table* db_open_flags(const char* filename, uint32_t flags);
+//flushes the page cache to disk, closes the db file, frees Pager and Table data structures
+void db_close(Table* table);
+PrepareResult db_prepare(Table* table, const char* sql, PreparedStatement** statement);
+//storage holds the statement until db_finalize(), which doesn't free it
+PrepareResult db_prepare_into(Table* table, const char* sql, PreparedStatementStorage* storage,
+                                PreparedStatement** statement);
+ExecuteResult db_execute(PreparedStatement* statement);
+StepResult db_step(PreparedStatement* statement);
+Row* db_row(PreparedStatement* statement);
+Value* db_value(PreparedStatement* statement);
+ExecuteResult db_execute_result(PreparedStatement* statement);
+void db_finalize(PreparedStatement* statement);
+//false if value is out of range for option
+bool db_set_option(Table* table, DbOption option, uint32_t value);
+void db_get_stats(Table* table, DbStats* stats);
+//builds the hash index on id (kept up to date and reopened from then on)
+void db_create_hash_index(Table* table);
+void db_drop_hash_index(Table* table);
+uint64_t db_latency_percentile(Table* table, StatementType type, double percentile);
+//NULL if dest can't be opened
+Backup* db_backup_start(Table* table, const char* dest_path, bool incremental);
+BackupResult db_backup_step(Backup* backup, uint32_t max_pages);
+uint32_t db_backup_pages_copied(Backup* backup);
+void db_backup_finish(Backup* backup);
+
+/*Tracing, trace_start() returns false when built without DB_TRACE*/
+bool trace_start(const char* path);
+//writes the recorded events to the file, returns how many
+uint64_t trace_stop();
+bool trace_enabled();
+
+/*Debugging output, printed to stdout*/
+void db_print_tree(Table* table);
+void db_print_constants();
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef DB_INTERNAL_H
+#define DB_INTERNAL_H
+
+/*Engine internals: node layout, pager, scans, latency histograms and
+tracing. db.c, the REPL and the benchmarks use these; embedders only
+need db.h.*/
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<sys/types.h> //for ssize_t, off_t
+#include<pthread.h> //for the pager lock
+#include<stdatomic.h>
+#include "db.h"
+
+//aggregate functions a select can compute instead of printing rows
+typedef enum{
+    AGGREGATE_NONE,
+    AGGREGATE_COUNT,
+    AGGREGATE_MIN,
+    AGGREGATE_MAX,
+    AGGREGATE_SUM,
+    AGGREGATE_AVG
+} AggregateType;
+
+typedef enum{
+    COLUMN_ALL, // *
+    COLUMN_ID,
+    COLUMN_USERNAME,
+    COLUMN_EMAIL
+} Column;
+
+// (Struct*)0 is a null pointer but does not get dereferenced by
+// -> cuz here sizeof simply returns the amount of bytes allocated by definition of the data type ( I hope this is right)
+#define size_of_attribute(Struct,Attribute) sizeof(((Struct*)0)->Attribute)
+
+extern const uint32_t ID_SIZE;
+extern const uint32_t USERNAME_SIZE;
+extern const uint32_t EMAIL_SIZE;
+extern const uint32_t ID_OFFSET;
+extern const uint32_t USERNAME_OFFSET;
+extern const uint32_t EMAIL_OFFSET;
+extern const uint32_t ROW_SIZE;
+
+//called for each row a select produces, returning false stops the statement
+typedef bool (*RowVisitor)(Row* row, void* arg);
+
+/* Bump allocator for memory that lives as long as one statement:
+nothing is freed on its own, arena_free() drops every block at once.
+An arena can start out in memory its owner provides (arena_init), and
+only mallocs blocks once that is used up.*/
+#define ARENA_BLOCK_SIZE (64*1024)
+#define ARENA_FIRST_BLOCK_SIZE 4096 //a point lookup fits, collected row and sql copy
+typedef struct ArenaBlock ArenaBlock;
+typedef struct{
+    ArenaBlock* blocks; //newest first
+    uint8_t* first; //owner's memory, not freed by arena_free(), may be NULL
+    size_t first_size;
+    size_t first_used;
+}Arena;
+
+typedef struct{
+    StatementType type;
+    Row row_to_insert; //only used by insert statement
+    AggregateType aggregate; //only used by select statement
+    Column aggregate_column;
+    Column order_by;
+    bool has_limit;
+    uint32_t limit;
+    uint32_t offset;
+    bool has_where_id; //select where id = <where_id>
+    uint32_t where_id;
+    RowVisitor emit_row; //where a select sends its rows
+    void* emit_arg;
+    Value aggregate_result;
+    Arena* arena; //scratch memory while executing, NULL = execute_statement() makes one
+} Statement;
+
+#define DEFAULT_SORT_BUDGET 4096 //rows
+extern const uint32_t PAGE_SIZE;
+#define TABLE_MAX_PAGES 100
+
+/* Page frames are carved out of slabs of PAGE_FRAMES_PER_SLAB pages,
+aligned to PAGE_SIZE so they can be handed to O_DIRECT reads and writes.
+A free frame stores the next free frame in its first bytes.*/
+#define PAGE_FRAMES_PER_SLAB 16
+#define PAGE_SLABS ((TABLE_MAX_PAGES+PAGE_FRAMES_PER_SLAB-1)/PAGE_FRAMES_PER_SLAB)
+typedef struct{
+    void* slabs[PAGE_SLABS];
+    uint32_t num_slabs;
+    void* free_frames;
+}FrameAllocator;
+
+//Leaf nodes and internal nodes have different layouts.
+//To keep track of node type
+//Each node corresponds to one page
+typedef enum{
+    NODE_INTERNAL,
+    NODE_LEAF
+}NodeType;
+
+/*Node layout, see db.c*/
+extern const uint32_t NODE_TYPE_SIZE;
+extern const uint32_t NODE_TYPE_OFFSET;
+extern const uint32_t IS_ROOT_SIZE;
+extern const uint32_t IS_ROOT_OFFSET;
+extern const uint32_t PARENT_POINTER_SIZE;
+extern const uint32_t PARENT_POINTER_OFFSET;
+extern const uint8_t COMMON_NODE_HEADER_SIZE;
+extern const uint32_t LEAF_NODE_NUM_CELLS_SIZE;
+extern const uint32_t LEAF_NODE_NUM_CELLS_OFFSET;
+extern const uint32_t LEAF_NODE_HEADER_SIZE;
+extern const uint32_t LEAF_NODE_KEY_SIZE;
+extern const uint32_t LEAF_NODE_KEY_OFFSET;
+extern const uint32_t LEAF_NODE_VALUE_SIZE;
+extern const uint32_t LEAF_NODE_VALUE_OFFSET;
+extern const uint32_t LEAF_NODE_CELL_SIZE;
+extern const uint32_t LEAF_NODE_SPACE_FOR_CELLS;
+extern const uint32_t LEAF_NODE_MAX_CELLS;
+extern const uint32_t LEAF_NODE_RIGHT_SPLIT_COUNT;
+extern const uint32_t LEAF_NODE_LEFT_SPLIT_COUNT;
+extern const uint32_t INTERNAL_NODE_NUM_KEYS_SIZE;
+extern const uint32_t INTERNAL_NODE_NUM_KEYS_OFFSET;
+extern const uint32_t INTERNAL_NODE_RIGHT_CHILD_SIZE;
+extern const uint32_t INTERNAL_NODE_RIGHT_CHILD_OFFSET;
+extern const uint32_t INTERNAL_NODE_HEADER_SIZE;
+extern const uint32_t INTERNAL_NODE_NUM_KEY_SIZE;
+extern const uint32_t INTERNAL_NODE_CHILD_SIZE;
+extern const uint32_t INTERNAL_NODE_CELL_SIZE;
+extern const uint32_t INTERNAL_NODE_MAX_CELLS;
+
+/* HDR-style latency histogram: values (in ns) are bucketed by power of two,
+and each power of two is split into LATENCY_SUB_BUCKETS linear buckets,
+so a reported percentile is within 1/LATENCY_SUB_BUCKETS of the real value.*/
+#define LATENCY_SUB_BUCKET_BITS 3
+#define LATENCY_SUB_BUCKETS (1<<LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS (64*LATENCY_SUB_BUCKETS)
+typedef struct{
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total_count;
+    uint64_t max;
+}LatencyHistogram;
+
+//The Pager struct: accesses file and page cache
+typedef struct{
+    int file_descriptor;
+    uint32_t file_length;
+    uint32_t num_pages;
+    void* pages[TABLE_MAX_PAGES];
+    FrameAllocator frames; //where pages[] come from
+    bool compress_pages; //compress pages on writeback (.compress on)
+    bool direct_io; //O_DIRECT: pages[] is the only cache of the file
+    uint32_t io_unit; //O_DIRECT writes are whole multiples of this (its alignment), 1 otherwise
+    void* write_buffer; //aligned, pads compressed pages to io_unit for O_DIRECT
+    pthread_mutex_t lock; //get_page() can be called from several threads (the bench readers)
+    PagerStats stats; //updated under lock
+    /*LSNs are in memory only (the page header has no room for one):
+    page_lsn is the LSN of the page's last change, 0 = unchanged since opening*/
+    uint64_t lsn; //last LSN handed out
+    uint64_t page_lsn[TABLE_MAX_PAGES];
+}Pager;
+
+struct Table{
+    Pager* pager;
+    uint32_t root_page_num; //to keep track of the btree
+    uint32_t sort_budget; //max rows an ORDER BY keeps in memory (.sort_budget)
+    uint64_t leaf_splits;
+    uint64_t root_splits;
+    LatencyHistogram latency[STATEMENT_TYPE_COUNT]; //per StatementType
+    char* backup_path; //dest of the last finished backup, NULL if none since opening
+    uint32_t backup_pages; //pages it holds
+    uint64_t backup_lsn; //pager LSN the last backup is consistent with
+    char* hash_index_path; //<db file>-hash
+    Pager* hash_index; //hash index on id, NULL if there is none
+};
+
+//callers keep cursors on the stack, the find functions fill them in
+typedef struct{
+    Table* table;
+    uint32_t page_num;
+    uint32_t cell_num;
+    bool end_of_table; //indicates a position one past the last element.
+}Cursor;
+
+//rows collected for db_step()
+typedef struct{
+    Row* rows;
+    uint32_t num_rows;
+    uint32_t capacity;
+}RowBuffer;
+
+/*Tracing*/
+/* Tracepoints are compiled in with -DDB_TRACE and cost nothing otherwise.
+While tracing is on (.trace on) every tracepoint records its start time,
+duration and one argument into a ring buffer, the newest
+TRACE_BUFFER_SIZE events are kept and written out by trace_stop().*/
+typedef enum{
+    TRACE_PAGE_READ, //arg: page number
+    TRACE_PAGE_WRITE, //arg: page number
+    TRACE_NODE_SPLIT, //arg: page number of the split leaf
+    TRACE_TREE_DESCENT, //arg: key searched for
+    TRACE_STATEMENT, //arg: StatementType
+    TRACE_OUTPUT //arg: unused, time spent handing rows to the client
+}TraceEventType;
+
+#define TRACE_BUFFER_SIZE (1<<16) //events, a power of two
+
+typedef struct{
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    TraceEventType type;
+    uint32_t arg;
+}TraceEvent;
+
+#ifdef DB_TRACE
+#define TRACE_BEGIN(name) uint64_t name = trace_enabled() ? now_ns() : 0
+#define TRACE_END(name, type, arg) \
+    do{ if(name) trace_record(type, name, now_ns()-name, arg); }while(0)
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_END(name, type, arg)
+#endif
+
+void trace_record(TraceEventType type, uint64_t start_ns, uint64_t duration_ns, uint32_t arg);
+
+/*Rows*/
+void serialize_row(Row* source, void* destination);
+void deserialize_row(void* source, Row* destination);
+
+/*Nodes*/
+bool is_node_root(void* node);
+void set_node_root(void* node, bool is_root);
+uint32_t* leaf_node_num_cells(void* node);
+void* leaf_node_cell(void* node, uint32_t cell_num);
+uint32_t* leaf_node_key(void* node, uint32_t cell_num);
+void* leaf_node_value(void* node, uint32_t cell_num);
+NodeType get_node_type(void* node);
+void set_node_type(void* node, NodeType type);
+void initialize_leaf_node(void* node);
+uint32_t* internal_node_num_keys(void* node);
+uint32_t* internal_node_right_child(void* node);
+uint32_t* internal_node_cell(void* node, uint32_t cell_num);
+uint32_t* internal_node_child(void* node, uint32_t child_num);
+uint32_t* internal_node_key(void* node, uint32_t key_num);
+void initialize_internal_node(void* node);
+uint32_t get_node_max_key(void* node);
+
+/*Memory*/
+void arena_init(Arena* arena, void* first_block, size_t size);
+void* arena_alloc(Arena* arena, size_t size);
+void arena_free(Arena* arena);
+void* frame_alloc(FrameAllocator* frames);
+void frame_free(FrameAllocator* frames, void* frame);
+void frame_allocator_free(FrameAllocator* frames);
+
+/*Pager*/
+uint32_t compress_page(void* source, void* destination);
+void decompress_page(void* source, uint32_t length, void* destination);
+Pager* pager_open(const char* filename, bool direct_io);
+void* get_page(Pager* pager, uint32_t page_num);
+void* peek_page(Pager* pager, uint32_t page_num, void** frame);
+void release_peeked_page(Pager* pager, void* frame);
+void pager_flush(Pager* pager, uint32_t page_num);
+void pager_mark_dirty(Pager* pager, uint32_t page_num);
+void pager_close(Pager* pager);
+uint32_t get_unused_page_num(Pager* pager);
+void pager_io_error(const char* what); //prints errno and exits
+
+/*Statistics*/
+void latency_record(LatencyHistogram* histogram, uint64_t value);
+uint64_t latency_percentile(LatencyHistogram* histogram, double percentile);
+uint64_t now_ns();
+
+/*B-tree*/
+void leaf_node_find(Table* table, uint32_t page_num, uint32_t key, Cursor* cursor);
+void internal_node_find(Table* table, uint32_t page_num, uint32_t key, Cursor* cursor);
+void table_find(Table* table, uint32_t key, Cursor* cursor);
+bool table_lookup(Table* table, uint32_t key, Cursor* cursor);
+void* table_edge_leaf(Table* table, bool rightmost);
+uint32_t count_subtree(Table* table, uint32_t page_num);
+uint64_t sum_subtree_keys(Table* table, uint32_t page_num);
+void* cursor_value(Cursor* cursor);
+void create_new_root(Table* table,uint32_t right_child_page_num);
+void leaf_node_split_and_insert(Cursor* cursor, uint32_t key, Row* value);
+void leaf_node_insert(Cursor* cursor, uint32_t key, Row* value);
+
+/*Hash index*/
+void hash_index_init(Pager* index);
+bool hash_index_find(Pager* index, uint32_t key, uint32_t* leaf_page_num);
+void hash_index_put(Pager* index, uint32_t key, uint32_t leaf_page_num);
+void hash_index_leaf(Table* table, uint32_t page_num);
+
+/*Scans*/
+bool walk_subtree(Table* table, uint32_t page_num, RowVisitor visit, void* arg);
+
+/*Statements*/
+bool parse_count(char* string, uint32_t* count);
+//sql is tokenized in place
+PrepareResult prepare_statement(char* sql, Statement* statement);
+ExecuteResult execute_statement(Statement* statement,Table* table);
+
+#endif
@@ -0,0 +1,413 @@
+#define _GNU_SOURCE //for accept4
+#include<errno.h>
+#include<fcntl.h>
+#include<signal.h>
+#include<string.h>
+#include<unistd.h>
+#include<sys/epoll.h>
+#include<sys/socket.h>
+#include<sys/un.h>
+#include "db_internal.h" //for serialize_row()
+#include "server.h"
+
+/* One thread runs an epoll loop over the listening socket and every
+connection. Each readable connection has all of its complete frames
+handled at once, and the responses are queued on its write buffer,
+which is flushed as far as the socket takes it. Once a client has more
+than SERVER_OUTPUT_HIGH_WATER bytes of responses waiting, the loop stops
+reading from it and handling its frames until the socket has taken the
+output back below that mark. Statements run on the
+loop thread: the B-tree has no latches, so a statement can't run while
+another one is changing the tree.*/
+
+#define SERVER_MAX_EVENTS 64
+#define SERVER_READ_SIZE (64*1024)
+#define SERVER_MAX_FRAME (1024*1024)
+#define SERVER_BACKLOG 128
+#define SERVER_OUTPUT_HIGH_WATER (1024*1024)
+
+typedef struct{
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+}ByteBuffer;
+
+typedef struct{
+    int fd;
+    ByteBuffer in;
+    ByteBuffer out;
+    size_t out_sent; //bytes of out already written to the socket
+    uint32_t events; //epoll events registered for fd
+    bool closing; //client stopped sending, close once out is written
+    PreparedStatement** statements; //indexed by statement id
+    uint32_t num_statements;
+}Connection;
+
+volatile sig_atomic_t server_stopping = 0;
+
+void stop_server(int signal_number){
+    (void)signal_number;
+    server_stopping = 1;
+}
+
+void byte_buffer_append(ByteBuffer* buffer, const void* data, size_t length){
+    if(buffer->length + length > buffer->capacity){
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while(capacity < buffer->length + length){
+            capacity *= 2;
+        }
+        buffer->data = realloc(buffer->data, capacity);
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+void send_frame(Connection* connection, ServerResponse type, const void* payload, uint32_t length){
+    uint32_t frame_length = 1 + length;
+    uint8_t frame_type = type;
+    byte_buffer_append(&connection->out, &frame_length, sizeof(uint32_t));
+    byte_buffer_append(&connection->out, &frame_type, sizeof(uint8_t));
+    byte_buffer_append(&connection->out, payload, length);
+}
+
+void send_error(Connection* connection, ErrorStage stage, uint8_t code){
+    uint8_t payload[2] = {stage, code};
+    send_frame(connection, RESPONSE_ERROR, payload, sizeof(payload));
+}
+
+void send_value(Connection* connection, Value* value){
+    uint8_t payload[1+COLUMN_EMAIL_SIZE+1];
+    uint32_t length = 1;
+    payload[0] = value->type;
+    switch(value->type){
+        case(VALUE_NULL):
+            break;
+        case(VALUE_INTEGER):
+            memcpy(payload+1, &value->integer, sizeof(uint64_t));
+            length += sizeof(uint64_t);
+            break;
+        case(VALUE_REAL):
+            memcpy(payload+1, &value->real, sizeof(double));
+            length += sizeof(double);
+            break;
+        case(VALUE_TEXT):
+            length += strlen(value->text);
+            memcpy(payload+1, value->text, length-1);
+            break;
+    }
+    send_frame(connection, RESPONSE_VALUE, payload, length);
+}
+
+PreparedStatement* connection_statement(Connection* connection, uint8_t* payload, uint32_t length){
+    if(length < sizeof(uint32_t)){
+        return NULL;
+    }
+    uint32_t id;
+    memcpy(&id, payload, sizeof(uint32_t));
+    if(id >= connection->num_statements){
+        return NULL;
+    }
+    return connection->statements[id];
+}
+
+void handle_prepare(Connection* connection, Table* table, uint8_t* payload, uint32_t length){
+    char* sql = malloc(length+1);
+    memcpy(sql, payload, length);
+    sql[length] = 0;
+    PreparedStatement* statement;
+    PrepareResult result = db_prepare(table, sql, &statement);
+    free(sql);
+    if(result != PREPARE_SUCCESS){
+        send_error(connection, ERROR_PREPARE, result);
+        return;
+    }
+
+    //reuse the id of a finalized statement if there is one
+    uint32_t id = 0;
+    while(id < connection->num_statements && connection->statements[id] != NULL){
+        id++;
+    }
+    if(id == connection->num_statements){
+        connection->num_statements += 1;
+        connection->statements = realloc(connection->statements,
+                                connection->num_statements*sizeof(PreparedStatement*));
+    }
+    connection->statements[id] = statement;
+    send_frame(connection, RESPONSE_OK, &id, sizeof(uint32_t));
+}
+
+void handle_fetch(Connection* connection, PreparedStatement* statement, uint32_t max_rows){
+    uint8_t row[ROW_SIZE];
+    uint8_t more = 0;
+    uint32_t sent = 0;
+    while(true){
+        if(sent == max_rows){
+            more = 1;
+            break;
+        }
+        StepResult step = db_step(statement);
+        if(step == STEP_ERROR){
+            send_error(connection, ERROR_EXECUTE, db_execute_result(statement));
+            return;
+        }
+        if(step == STEP_DONE){
+            break;
+        }
+        if(step == STEP_ROW){
+            serialize_row(db_row(statement), row);
+            send_frame(connection, RESPONSE_ROW, row, ROW_SIZE);
+        }else{
+            send_value(connection, db_value(statement));
+        }
+        sent++;
+    }
+    send_frame(connection, RESPONSE_DONE, &more, sizeof(uint8_t));
+}
+
+void handle_frame(Connection* connection, Table* table, uint8_t op, uint8_t* payload, uint32_t length){
+    if(op == OP_PREPARE){
+        handle_prepare(connection, table, payload, length);
+        return;
+    }
+
+    PreparedStatement* statement = connection_statement(connection, payload, length);
+    if(statement == NULL){
+        send_error(connection, ERROR_PROTOCOL, 0);
+        return;
+    }
+    switch(op){
+        case(OP_EXECUTE): {
+            ExecuteResult result = db_execute(statement);
+            if(result != EXECUTE_SUCCESS){
+                send_error(connection, ERROR_EXECUTE, result);
+            }else{
+                send_frame(connection, RESPONSE_OK, NULL, 0);
+            }
+            break;
+        }
+        case(OP_FETCH): {
+            uint32_t max_rows;
+            if(length < 2*sizeof(uint32_t)){
+                send_error(connection, ERROR_PROTOCOL, 0);
+                break;
+            }
+            memcpy(&max_rows, payload+sizeof(uint32_t), sizeof(uint32_t));
+            handle_fetch(connection, statement, max_rows);
+            break;
+        }
+        case(OP_FINALIZE): {
+            uint32_t id;
+            memcpy(&id, payload, sizeof(uint32_t));
+            db_finalize(statement);
+            connection->statements[id] = NULL;
+            send_frame(connection, RESPONSE_OK, NULL, 0);
+            break;
+        }
+        default:
+            send_error(connection, ERROR_PROTOCOL, 0);
+    }
+}
+
+bool output_full(Connection* connection){
+    return connection->out.length - connection->out_sent > SERVER_OUTPUT_HIGH_WATER;
+}
+
+/*Handles the complete frames in the read buffer until the output is full.
+Returns false if the client sent a frame that can't be valid.*/
+bool handle_frames(Connection* connection, Table* table){
+    size_t position = 0;
+    while(connection->in.length - position >= sizeof(uint32_t) && !output_full(connection)){
+        uint32_t frame_length;
+        memcpy(&frame_length, connection->in.data+position, sizeof(uint32_t));
+        if(frame_length == 0 || frame_length > SERVER_MAX_FRAME){
+            connection->in.length = 0; //drop the rest, nothing after it can be framed
+            return false;
+        }
+        if(connection->in.length - position - sizeof(uint32_t) < frame_length){
+            break; //rest of the frame hasn't arrived yet
+        }
+        uint8_t* frame = connection->in.data + position + sizeof(uint32_t);
+        handle_frame(connection, table, frame[0], frame+1, frame_length-1);
+        position += sizeof(uint32_t) + frame_length;
+    }
+    memmove(connection->in.data, connection->in.data+position, connection->in.length-position);
+    connection->in.length -= position;
+    return true;
+}
+
+void close_connection(int epoll_fd, Connection* connection){
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    for(uint32_t i = 0; i < connection->num_statements; i++){
+        if(connection->statements[i] != NULL){
+            db_finalize(connection->statements[i]);
+        }
+    }
+    free(connection->statements);
+    free(connection->in.data);
+    free(connection->out.data);
+    free(connection);
+}
+
+/*Writes as much of the output as the socket takes.
+Returns false if the connection is broken.*/
+bool flush_connection(int epoll_fd, Connection* connection){
+    while(connection->out_sent < connection->out.length){
+        ssize_t bytes_written = send(connection->fd, connection->out.data+connection->out_sent,
+                                    connection->out.length-connection->out_sent, MSG_NOSIGNAL);
+        if(bytes_written == -1){
+            if(errno == EAGAIN || errno == EWOULDBLOCK){
+                break;
+            }
+            return false;
+        }
+        connection->out_sent += bytes_written;
+    }
+    if(connection->out_sent == connection->out.length){
+        connection->out.length = 0;
+        connection->out_sent = 0;
+    }
+
+    //only ask for EPOLLOUT while there is something left to write,
+    //and stop reading while the client isn't taking its responses
+    uint32_t events = (connection->closing || output_full(connection) ? 0 : EPOLLIN) |
+                        (connection->out.length > 0 ? EPOLLOUT : 0);
+    if(events != connection->events){
+        struct epoll_event event;
+        event.events = events;
+        event.data.ptr = connection;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+    return true;
+}
+
+/*Flushes the output, handling the frames held back by a full output as
+it drains. Returns false if the connection is broken.*/
+bool drain_connection(int epoll_fd, Connection* connection, Table* table){
+    while(true){
+        if(!flush_connection(epoll_fd, connection)){
+            return false;
+        }
+        size_t pending = connection->in.length;
+        if(pending == 0 || output_full(connection)){
+            return true;
+        }
+        if(!handle_frames(connection, table)){
+            connection->closing = true;
+        }
+        if(connection->in.length == pending){
+            return true; //only part of a frame is left
+        }
+    }
+}
+
+/*Returns false once the client hung up or sent garbage*/
+bool read_connection(Connection* connection, Table* table){
+    uint8_t chunk[SERVER_READ_SIZE];
+    while(!output_full(connection)){
+        ssize_t bytes_read = recv(connection->fd, chunk, SERVER_READ_SIZE, 0);
+        if(bytes_read == 0){
+            return false;
+        }
+        if(bytes_read == -1){
+            if(errno == EAGAIN || errno == EWOULDBLOCK){
+                return true;
+            }
+            return false;
+        }
+        byte_buffer_append(&connection->in, chunk, bytes_read);
+        if(!handle_frames(connection, table)){
+            return false;
+        }
+    }
+    return true;
+}
+
+void accept_connections(int epoll_fd, int listen_fd){
+    while(true){
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd == -1){
+            return; //EAGAIN: no more pending connections
+        }
+        Connection* connection = calloc(1, sizeof(Connection));
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1){
+            close(fd);
+            free(connection);
+        }
+    }
+}
+
+int run_server(Table* table, const char* socket_path){
+    struct sockaddr_un address;
+    if(strlen(socket_path) >= sizeof(address.sun_path)){
+        printf("Socket path too long.\n");
+        return EXIT_FAILURE;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socket_path);
+    if(listen_fd == -1 ||
+        bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) == -1 ||
+        listen(listen_fd, SERVER_BACKLOG) == -1){
+        printf("Unable to listen on %s: %d\n", socket_path, errno);
+        return EXIT_FAILURE;
+    }
+
+    //no SA_RESTART, so a signal wakes up epoll_wait
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; //NULL marks the listening socket
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    printf("Listening on %s\n", socket_path);
+    fflush(stdout);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while(!server_stopping){
+        int num_events = epoll_wait(epoll_fd, events, SERVER_MAX_EVENTS, -1);
+        if(num_events == -1){
+            if(errno == EINTR){
+                continue;
+            }
+            printf("Error waiting for events: %d\n", errno);
+            break;
+        }
+        for(int i = 0; i < num_events; i++){
+            Connection* connection = events[i].data.ptr;
+            if(connection == NULL){
+                accept_connections(epoll_fd, listen_fd);
+                continue;
+            }
+            if(!connection->closing && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))){
+                connection->closing = !read_connection(connection, table);
+            }
+            //answer whatever was handled, even if the client is done sending
+            if(!drain_connection(epoll_fd, connection, table) ||
+                (connection->closing && connection->out.length == 0)){
+                close_connection(epoll_fd, connection);
+            }
+        }
+    }
+
+    //open connections are dropped when the process exits
+    close(epoll_fd);
+    close(listen_fd);
+    unlink(socket_path);
+    return 0;
+}
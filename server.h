@@ -0,0 +1,48 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "db.h"
+
+/*Server mode: ./main <db> -s <socket path>
+
+Clients connect to a Unix domain socket and exchange frames:
+    length (uint32, counts the bytes after it) | type (uint8) | payload
+All integers are in the host's byte order, the socket is local.
+
+Requests:
+    OP_PREPARE   sql text                        -> RESPONSE_OK (uint32 statement id)
+    OP_EXECUTE   uint32 statement id             -> RESPONSE_OK
+    OP_FETCH     uint32 statement id, uint32 max -> up to max RESPONSE_ROW/RESPONSE_VALUE,
+                                                    then RESPONSE_DONE (uint8 more rows left)
+    OP_FINALIZE  uint32 statement id             -> RESPONSE_OK
+Any request can be answered with RESPONSE_ERROR (uint8 ErrorStage, uint8 code),
+code is the PrepareResult or ExecuteResult.
+
+Requests on a connection are answered in order, so a client can pipeline them
+without waiting for each response.*/
+
+typedef enum{
+    OP_PREPARE = 1,
+    OP_EXECUTE = 2,
+    OP_FETCH = 3,
+    OP_FINALIZE = 4
+}ServerOp;
+
+typedef enum{
+    RESPONSE_OK = 0,
+    RESPONSE_ROW = 1, //serialized row, ROW_SIZE bytes
+    RESPONSE_VALUE = 2, //uint8 ValueType, then uint64, double or text
+    RESPONSE_DONE = 3,
+    RESPONSE_ERROR = 4
+}ServerResponse;
+
+typedef enum{
+    ERROR_PREPARE = 1,
+    ERROR_EXECUTE = 2,
+    ERROR_PROTOCOL = 3 //bad frame, op or statement id
+}ErrorStage;
+
+//runs until SIGINT/SIGTERM, returns 0 on a clean shutdown
+int run_server(Table* table, const char* socket_path);
+
+#endif
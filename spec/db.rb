@@ -11,7 +11,7 @@ extend RSpec::Matchers
 
 describe 'database' do
   before do
-    `rm -rf test.db`
+    `rm -rf test.db test.db-hash`
   end
     def run_script(commands)
       raw_output = nil
@@ -174,4 +174,393 @@ describe 'database' do
           "db > ",
         ])
       end
-  end
\ No newline at end of file
+
+      it 'keeps data in compressed pages after closing connection' do
+        script = (1..14).map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        result1 = run_script([".compress on"] + script + [".exit"])
+        expect(result1.last).to eq("db > ")
+
+        result2 = run_script([
+          ".btree",
+          ".exit",
+        ])
+        expect(result2).to match_array([
+          "db > Tree:",
+          "- internal (size 1)",
+          " - leaf (size 7)",
+          "  - 1",
+          "  - 2",
+          "  - 3",
+          "  - 4",
+          "  - 5",
+          "  - 6",
+          "  - 7",
+          " - key 7",
+          " - leaf (size 7)",
+          "  - 8",
+          "  - 9",
+          "  - 10",
+          "  - 11",
+          "  - 12",
+          "  - 13",
+          "  - 14",
+          "db > ",
+        ])
+      end
+
+      it 'prints all rows of a multi-leaf btree in id order' do
+        script = [14, 3, 9, 1, 12, 7, 5, 2, 11, 4, 13, 6, 10, 8].map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script << "select"
+        script << ".exit"
+        result = run_script(script)
+
+        expect(result[14...(result.length)]).to eq(
+          ["db > (1, user1, person1@example.com)"] +
+          (2..14).map { |i| "(#{i}, user#{i}, person#{i}@example.com)" } +
+          ["Executed.", "db > "]
+        )
+      end
+
+      it 'computes aggregates over a multi-leaf btree' do
+        script = (1..14).map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script += [
+          "select count(*)",
+          "select min(id)",
+          "select max(id)",
+          "select sum(id)",
+          "select avg(id)",
+          "select max(username)",
+          "select min(email)",
+          "select sum(email)",
+          ".exit",
+        ]
+        result = run_script(script)
+
+        expect(result[14...(result.length)]).to eq([
+          "db > (14)",
+          "Executed.",
+          "db > (1)",
+          "Executed.",
+          "db > (14)",
+          "Executed.",
+          "db > (105)",
+          "Executed.",
+          "db > (7.50)",
+          "Executed.",
+          "db > (user9)",
+          "Executed.",
+          "db > (person10@example.com)",
+          "Executed.",
+          "db > Syntax error. Could not parse statement.",
+          "db > ",
+        ])
+      end
+
+      it 'orders rows by a text column with limit and offset' do
+        script = (1..14).map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script += [
+          "select order by username limit 3 offset 1",
+          ".sort_budget 4",
+          "select order by username offset 10",
+          ".sort_budget 2",
+          "select order by email limit 2 offset 11",
+          ".exit",
+        ]
+        result = run_script(script)
+
+        expect(result[14...(result.length)]).to eq([
+          "db > (10, user10, person10@example.com)",
+          "(11, user11, person11@example.com)",
+          "(12, user12, person12@example.com)",
+          "Executed.",
+          "db > db > (6, user6, person6@example.com)",
+          "(7, user7, person7@example.com)",
+          "(8, user8, person8@example.com)",
+          "(9, user9, person9@example.com)",
+          "Executed.",
+          "db > db > (7, user7, person7@example.com)",
+          "(8, user8, person8@example.com)",
+          "Executed.",
+          "db > ",
+        ])
+      end
+
+      it 'rejects out of range numbers and repeated clauses' do
+        result = run_script([
+          "insert 1 user1 person1@example.com",
+          "select where id = 4294967297",
+          "select limit 4294967296",
+          "select order by username order by email",
+          "select limit 1 limit 2",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > Executed.",
+          "db > Syntax error. Could not parse statement.",
+          "db > Syntax error. Could not parse statement.",
+          "db > Syntax error. Could not parse statement.",
+          "db > Syntax error. Could not parse statement.",
+          "db > ",
+        ])
+      end
+
+      it 'prints performance statistics' do
+        script = (1..14).map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script << ".stats"
+        script << ".stats"
+        script << ".exit"
+        result = run_script(script)
+
+        #the tree walk behind .stats doesn't count towards the next .stats
+        expect(result.grep(/^cache_(hits|misses):/).each_slice(2).to_a.uniq.length).to eq(1)
+        expect(result).to include(
+          "db > Stats:",
+          "pages_read: 0",
+          "leaf_splits: 1",
+          "root_splits: 1",
+          "tree_height: 2",
+          "level 1: 2 nodes, fill 0.54",
+        )
+        expect(result.grep(/^insert latency \(ns\): count 14 /).length).to eq(2)
+
+        #nor does it leave pages cached, the select still misses on all 3
+        result = run_script([".stats", "select count(*)", ".stats", ".exit"])
+        expect(result.grep(/^cache_misses:/)).to eq(["cache_misses: 0", "cache_misses: 3"])
+      end
+
+      it 'runs a script in batch mode without prompts' do
+        File.write("test.db.sql", [
+          "insert 1 user1 person1@example.com; insert 2 user2 person2@example.com",
+          "insert 2 user2 person2@example.com",
+          "insert 3 user3 a;b@example.com;",
+          "select count(*); select",
+        ].join("\n"))
+        result = `./main test.db -f test.db.sql`.split("\n")
+        File.delete("test.db.sql")
+        expect(result).to eq([
+          "Error: Duplicate key.",
+          "(3)",
+          "(1, user1, person1@example.com)",
+          "(2, user2, person2@example.com)",
+          "(3, user3, a;b@example.com)",
+        ])
+
+        result = run_script([
+          "select count(*)",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > (3)",
+          "Executed.",
+          "db > ",
+        ])
+      end
+
+      it 'serves pipelined statements over a unix socket' do
+        require 'socket'
+        server = IO.popen(["./main", "test.db", "-s", "test.db.sock"])
+        expect(server.gets).to eq("Listening on test.db.sock\n")
+
+        frame = ->(op, payload) { [payload.bytesize + 1, op].pack("LC") + payload }
+        socket = UNIXSocket.new("test.db.sock")
+        # prepare (ids 0, 1, 2), execute the inserts and fetch the select in one write
+        socket.write(
+          frame.(1, "insert 1 user1 person1@example.com") +
+          frame.(1, "insert 2 user2 person2@example.com") +
+          frame.(1, "select") +
+          frame.(2, [0].pack("L")) +
+          frame.(2, [1].pack("L")) +
+          frame.(3, [2, 1].pack("LL")) +
+          frame.(3, [2, 10].pack("LL")) +
+          frame.(4, [2].pack("L")) +
+          frame.(1, "insert x")
+        )
+        responses = 11.times.map do
+          length = socket.read(4).unpack1("L")
+          body = socket.read(length)
+          [body.getbyte(0), body.byteslice(1..)]
+        end
+        socket.close
+        Process.kill("TERM", server.pid)
+        server.close
+
+        rows = responses.select { |type, _| type == 1 }.map do |_, row|
+          id, username, email = row.unpack("LZ33Z256")
+          "(#{id}, #{username}, #{email})"
+        end
+        expect(responses.map(&:first)).to eq([0, 0, 0, 0, 0, 1, 3, 1, 3, 0, 4])
+        expect(responses[0..2].map { |_, id| id.unpack1("L") }).to eq([0, 1, 2])
+        expect(rows).to eq([
+          "(1, user1, person1@example.com)",
+          "(2, user2, person2@example.com)",
+        ])
+        expect(responses[6][1].unpack1("C")).to eq(1)
+        expect(responses[8][1].unpack1("C")).to eq(0)
+        expect(responses[10][1].unpack("CC")).to eq([1, 2])
+
+        result = run_script([
+          "select count(*)",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > (2)",
+          "Executed.",
+          "db > ",
+        ])
+      end
+
+      it 'reads back pages written with O_DIRECT, compressed or not' do
+        script = (1..20).map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        File.write("test.db.sql", ([".compress on"] + script[0...10]).join("\n"))
+        `./main test.db -d -f test.db.sql`
+        File.write("test.db.sql", script[10..].join("\n"))
+        `./main test.db -d -f test.db.sql`
+        File.write("test.db.sql", "select count(*)\nselect sum(id)")
+        result = `./main test.db -d -f test.db.sql`.split("\n")
+        File.delete("test.db.sql")
+        expect(result).to eq(["(20)", "(210)"])
+        expect(File.size("test.db") % 4096).to eq(0)
+
+        result = run_script([
+          "select max(username)",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > (user9)",
+          "Executed.",
+          "db > ",
+        ])
+      end
+
+      it 'takes full and incremental backups' do
+        script = (1..10).map do |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script << ".backup test.db.bak"
+        (11..14).each do |i|
+          script << "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script << ".backup test.db.bak incremental"
+        script << "insert 15 user15 person15@example.com"
+        script << ".backup test.db.bak incremental"
+        #a different file doesn't hold the last backup, so it gets a full copy
+        script << ".backup test.db.bak2 incremental"
+        script << ".exit"
+        result = run_script(script)
+        expect(result.grep(/Backup/)).to eq([
+          "db > Backup complete: 1 pages copied.",
+          "db > Backup complete: 3 pages copied.",
+          "db > Backup complete: 1 pages copied.",
+          "db > Backup complete: 3 pages copied.",
+        ])
+
+        File.write("test.db.sql", "select count(*)\nselect sum(id)")
+        result = `./main test.db.bak -f test.db.sql`.split("\n")
+        result2 = `./main test.db.bak2 -f test.db.sql`.split("\n")
+        File.delete("test.db.sql", "test.db.bak", "test.db.bak2")
+        expect(result).to eq(["(15)", "(120)"])
+        expect(result2).to eq(["(15)", "(120)"])
+      end
+
+      it 'says when tracing is not compiled in' do
+        result = run_script([
+          ".trace on",
+          ".trace off",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > Tracing isn't compiled in, rebuild with -DDB_TRACE.",
+          "db > db > ",
+        ])
+      end
+
+      it 'looks up ids through the hash index' do
+        script = [".hash_index on"]
+        [7, 3, 12, 1, 9, 14, 5, 11, 2, 13, 8, 4, 10, 6].each do |i|
+          script << "insert #{i} user#{i} person#{i}@example.com"
+        end
+        script << "select where id = 1"
+        script << "select where id = 14"
+        script << "select where id = 15"
+        script << ".exit"
+        result = run_script(script)
+        expect(result.last(6)).to eq([
+          "db > (1, user1, person1@example.com)",
+          "Executed.",
+          "db > (14, user14, person14@example.com)",
+          "Executed.",
+          "db > Executed.",
+          "db > ",
+        ])
+        expect(File.exist?("test.db-hash")).to eq(true)
+
+        result = run_script([
+          "select where id = 14",
+          "select where id = 7 offset 1",
+          ".hash_index off",
+          "select where id = 6",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > (14, user14, person14@example.com)",
+          "Executed.",
+          "db > Executed.",
+          "db > db > (6, user6, person6@example.com)",
+          "Executed.",
+          "db > ",
+        ])
+        expect(File.exist?("test.db-hash")).to eq(false)
+      end
+
+      it 'rebuilds a hash index left over from another database' do
+        run_script([".hash_index on"] + (1..14).map { |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        } + [".exit"])
+        File.rename("test.db-hash", "test.db.stale")
+        File.delete("test.db")
+        run_script([".hash_index on"] + (101..114).map { |i|
+          "insert #{i} user#{i} person#{i}@example.com"
+        } + [".exit"])
+        File.rename("test.db.stale", "test.db-hash")
+
+        result = run_script([
+          "select where id = 105",
+          "select where id = 5",
+          ".exit",
+        ])
+        expect(result).to eq([
+          "db > (105, user105, person105@example.com)",
+          "Executed.",
+          "db > Executed.",
+          "db > ",
+        ])
+      end
+
+      it 'keeps the hash index marked unclean while the database is open' do
+        run_script([".hash_index on", "insert 1 user1 person1@example.com", ".exit"])
+        clean = -> { File.binread("test.db-hash", 4, 12).unpack1("L") }
+        expect(clean.()).to eq(1)
+
+        IO.popen(["./main", "test.db"], "r+") do |pipe|
+          deadline = Time.now + 5
+          sleep 0.01 until clean.() == 0 || Time.now > deadline
+          expect(clean.()).to eq(0)
+          pipe.puts "select where id = 1"
+          pipe.puts ".exit"
+          expect(pipe.read).to include("(1, user1, person1@example.com)")
+        end
+        expect(clean.()).to eq(1)
+      end
+  end